@@ -0,0 +1,84 @@
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "lattice.h"
+
+/**********************************************************************
+ * distance from every cell to the nearest crystal cell, capped at CAP
+ *
+ * note: each cell holds the floor of the exact Euclidean distance, or
+ * CAP if no crystal cell lies closer than CAP; update() lowers the
+ * cells within CAP of a newly stuck particle, so its cost is
+ * proportional to that disc and not to the lattice. Values only
+ * decrease, via compare-and-swap, so concurrent readers may see a
+ * distance that is briefly too large but never one lost to a race.
+***********************************************************************/
+class DistanceField {
+public:
+    static constexpr int CAP = 32;
+
+    explicit DistanceField(const int size)
+        : size_(size), cells_(static_cast<std::uint8_t*>(allocateCells(static_cast<std::size_t>(size) * size))) {
+        std::memset(cells_, CAP, static_cast<std::size_t>(size) * size);
+        for (int dx = -CAP; dx <= CAP; dx++) {
+            for (int dy = -CAP; dy <= CAP; dy++) {
+                const int distance = static_cast<int>(std::sqrt(dx * dx + dy * dy));
+                if (distance < CAP) {
+                    disc_.push_back({dx, dy, static_cast<std::uint8_t>(distance)});
+                }
+            }
+        }
+    }
+
+    ~DistanceField() {
+        std::free(cells_);
+    }
+
+    DistanceField(const DistanceField&) = delete;
+    DistanceField& operator=(const DistanceField&) = delete;
+
+    /* lower bound on the distance from (x, y) to the crystal, at most CAP */
+    int distance(const int x, const int y) const {
+        return __atomic_load_n(&cells_[index(x, y)], __ATOMIC_RELAXED);
+    }
+
+    /* lowers the distances around a cell that just joined the crystal */
+    void update(const int x, const int y) {
+        for (const Offset& offset : disc_) {
+            const int newX = x + offset.dx;
+            const int newY = y + offset.dy;
+            if (newX < 0 || newX >= size_ || newY < 0 || newY >= size_) {
+                continue;
+            }
+            std::uint8_t* cell = &cells_[index(newX, newY)];
+            std::uint8_t current = __atomic_load_n(cell, __ATOMIC_RELAXED);
+            while (offset.distance < current &&
+                   !__atomic_compare_exchange_n(cell, &current, offset.distance, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            }
+        }
+    }
+
+private:
+    struct Offset {
+        int dx;
+        int dy;
+        std::uint8_t distance;
+    };
+
+    std::size_t index(const int x, const int y) const {
+        return static_cast<std::size_t>(x) * size_ + static_cast<std::size_t>(y);
+    }
+
+    const int size_;
+    std::uint8_t* const cells_;
+    std::vector<Offset> disc_;
+};
+
+#endif
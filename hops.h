@@ -0,0 +1,250 @@
+#ifndef HOPS_H
+#define HOPS_H
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+/**********************************************************************
+ * exact displacement distributions after 2^k steps of the 9-move walk
+ *
+ * note: each step moves x and y independently by -1, 0 or +1 with
+ * equal probability, so after n steps each axis is an independent sum
+ * of n such moves; its distribution is built once at startup by
+ * repeatedly convolving the 2^(k-1) step table with itself and stored
+ * as a cumulative table over displacements -n .. n
+***********************************************************************/
+class DisplacementTables {
+public:
+    static constexpr int MIN_LEVEL = 2;
+    static constexpr int MAX_LEVEL = 8;
+
+    DisplacementTables() {
+        std::vector<double> probabilities = {1.0 / 3, 1.0 / 3, 1.0 / 3};
+        for (int level = 1; level <= MAX_LEVEL; level++) {
+            std::vector<double> doubled(2 * probabilities.size() - 1, 0.0);
+            for (std::size_t i = 0; i < probabilities.size(); i++) {
+                for (std::size_t k = 0; k < probabilities.size(); k++) {
+                    doubled[i + k] += probabilities[i] * probabilities[k];
+                }
+            }
+            probabilities = doubled;
+            if (level >= MIN_LEVEL) {
+                std::vector<double> cumulative(probabilities.size());
+                std::partial_sum(probabilities.begin(), probabilities.end(), cumulative.begin());
+                cumulative.back() = 1.0;
+                probabilities_.push_back(probabilities);
+                cumulative_.push_back(cumulative);
+            }
+        }
+    }
+
+    /* number of single steps replaced by one hop at level */
+    static int steps(const int level) {
+        return 1 << level;
+    }
+
+    /**********************************************************************
+     * largest level whose hop cannot touch the crystal or leave the
+     * lattice, given that the square of radius clearance around the
+     * walker is empty and inside the lattice; 0 if none is safe
+     *
+     * note: after n steps the walker is within max-norm distance n, and
+     * it sticks next to a crystal cell, so n <= clearance - 1 is needed
+    ***********************************************************************/
+    static int levelFor(const int clearance) {
+        int level = 0;
+        while (level < MAX_LEVEL && steps(level + 1) <= clearance - 1) {
+            level++;
+        }
+        return level >= MIN_LEVEL ? level : 0;
+    }
+
+    /* probability of displacement d along one axis after a hop at level */
+    double probability(const int level, const int d) const {
+        return probabilities_[level - MIN_LEVEL][d + steps(level)];
+    }
+
+    /* draws the displacement along one axis after a hop at level */
+    template <typename G>
+    int sample(G& generator, const int level) const {
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        const std::vector<double>& cumulative = cumulative_[level - MIN_LEVEL];
+        const double u = distribution(generator);
+        const int index = static_cast<int>(std::upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin());
+        return std::min(index, static_cast<int>(cumulative.size()) - 1) - steps(level);
+    }
+
+    /* advances (x, y) by 2^level steps of the walk in one draw per axis */
+    template <typename G>
+    void hop(G& generator, const int level, int& x, int& y) const {
+        x += sample(generator, level);
+        y += sample(generator, level);
+    }
+
+    /**********************************************************************
+     * compares each table with simulated single-step walks and prints a
+     * chi-square statistic per level to out
+     *
+     * note: bins with fewer than 5 expected samples are merged into the
+     * tails; the statistic should be close to its degrees of freedom
+    ***********************************************************************/
+    template <typename G>
+    void check(G& generator, const int walks, std::ostream& out) const {
+        std::uniform_int_distribution<int> move(-1, 1);
+        for (int level = MIN_LEVEL; level <= MAX_LEVEL; level++) {
+            const int n = steps(level);
+            std::vector<long> counts(2 * n + 1, 0);
+            for (int w = 0; w < walks; w++) {
+                int d = 0;
+                for (int s = 0; s < n; s++) {
+                    d += move(generator);
+                }
+                counts[d + n]++;
+            }
+            double statistic = 0;
+            int bins = 0;
+            double expected = 0;
+            long observed = 0;
+            for (int d = -n; d <= n; d++) {
+                expected += walks * probability(level, d);
+                observed += counts[d + n];
+                if (expected >= 5 && walks * (1 - cumulativeAt(level, d)) >= 5) {
+                    statistic += (observed - expected) * (observed - expected) / expected;
+                    bins++;
+                    expected = 0;
+                    observed = 0;
+                }
+            }
+            if (expected > 0) {
+                statistic += (observed - expected) * (observed - expected) / expected;
+                bins++;
+            }
+            out << "hop table " << n << " steps: chi-square " << statistic << " on " << bins - 1 << " degrees of freedom" << std::endl;
+        }
+    }
+
+private:
+    double cumulativeAt(const int level, const int d) const {
+        return cumulative_[level - MIN_LEVEL][d + steps(level)];
+    }
+
+    std::vector<std::vector<double>> probabilities_;
+    std::vector<std::vector<double>> cumulative_;
+};
+
+/**********************************************************************
+ * exact exit distributions of the 9-move walk from empty squares
+ *
+ * note: a step changes the max-norm distance from the start by at most
+ * one, so a walker started at the center of a square of radius L first
+ * leaves its interior on the ring of cells at distance exactly L. The
+ * probability of each of the 8L ring cells is computed once at startup
+ * by pushing probability mass through the interior, absorbing it on
+ * the ring, until less than TOLERANCE is left inside.
+***********************************************************************/
+class ExitTables {
+public:
+    static constexpr double TOLERANCE = 1e-12;
+
+    ExitTables() {
+        for (int radius = 2; radius <= 32; radius *= 2) {
+            build(radius);
+        }
+    }
+
+    /**********************************************************************
+     * index of the largest square whose exit can be sampled for a walker
+     * whose square of radius clearance is empty and inside the lattice,
+     * -1 if none
+     *
+     * note: the walker visits cells up to distance L and sticks next to a
+     * crystal cell, so L <= clearance - 1 is needed
+    ***********************************************************************/
+    int indexFor(const int clearance) const {
+        int index = -1;
+        while (index + 1 < static_cast<int>(radii_.size()) && radii_[index + 1] <= clearance - 1) {
+            index++;
+        }
+        return index;
+    }
+
+    /* moves (x, y) to where the walk first leaves the square at index */
+    template <typename G>
+    void exit(G& generator, const int index, int& x, int& y) const {
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        const std::vector<double>& cumulative = cumulative_[index];
+        const double u = distribution(generator);
+        const std::size_t cell = std::min(static_cast<std::size_t>(std::upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin()), cumulative.size() - 1);
+        x += ring_[index][cell].first;
+        y += ring_[index][cell].second;
+    }
+
+private:
+    void build(const int radius) {
+        const int side = 2 * radius + 1;
+        std::vector<double> mass(side * side, 0.0);
+        std::vector<double> next(side * side, 0.0);
+        std::vector<double> absorbed(side * side, 0.0);
+        mass[radius * side + radius] = 1.0;
+        double inside = 1.0;
+        while (inside > TOLERANCE) {
+            std::fill(next.begin(), next.end(), 0.0);
+            for (int i = 1; i < side - 1; i++) {
+                for (int k = 1; k < side - 1; k++) {
+                    const double share = mass[i * side + k] / 9;
+                    if (share == 0) {
+                        continue;
+                    }
+                    for (int dx = -1; dx <= 1; dx++) {
+                        for (int dy = -1; dy <= 1; dy++) {
+                            next[(i + dx) * side + k + dy] += share;
+                        }
+                    }
+                }
+            }
+            /* absorb mass that reached the ring */
+            inside = 0;
+            for (int i = 0; i < side; i++) {
+                for (int k = 0; k < side; k++) {
+                    if (i == 0 || i == side - 1 || k == 0 || k == side - 1) {
+                        absorbed[i * side + k] += next[i * side + k];
+                        next[i * side + k] = 0;
+                    } else {
+                        inside += next[i * side + k];
+                    }
+                }
+            }
+            mass.swap(next);
+        }
+
+        std::vector<std::pair<int, int>> ring;
+        std::vector<double> cumulative;
+        double total = 0;
+        for (int i = 0; i < side; i++) {
+            for (int k = 0; k < side; k++) {
+                if (i == 0 || i == side - 1 || k == 0 || k == side - 1) {
+                    total += absorbed[i * side + k];
+                    ring.push_back(std::make_pair(i - radius, k - radius));
+                    cumulative.push_back(total);
+                }
+            }
+        }
+        for (double& value : cumulative) {
+            value /= total;
+        }
+        radii_.push_back(radius);
+        ring_.push_back(ring);
+        cumulative_.push_back(cumulative);
+    }
+
+    std::vector<int> radii_;
+    std::vector<std::vector<std::pair<int, int>>> ring_;
+    std::vector<std::vector<double>> cumulative_;
+};
+
+#endif
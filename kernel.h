@@ -0,0 +1,185 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* moves of the walk; move k is dx = k / 3 - 1, dy = k % 3 - 1 */
+const int MOVES = 9;
+
+/**********************************************************************
+ * distribution over the 9 moves of the walk, sampled in O(1) from one
+ * 21-bit draw with Walker's alias method
+ *
+ * note: the table has 16 columns so the column is the top 4 bits of
+ * the draw; columns past the 9th have probability 0 and always take
+ * their alias. Column c keeps move c if the low 17 bits of the draw are
+ * below threshold_[c] and takes alias_[c] otherwise, so probabilities
+ * are exact to 2^-21 and three draws fit in a 64-bit output.
+***********************************************************************/
+class MoveKernel {
+public:
+    static constexpr int COLUMNS = 16;
+    static constexpr int BITS = 21;
+    static constexpr std::uint32_t SCALE = 1u << (BITS - 4);
+
+    /* weights need not be normalized, but must be finite with a positive
+       sum; parseOptions rejects any that are not */
+    explicit MoveKernel(const std::vector<double>& weights) : probabilities_(MOVES) {
+        double total = 0;
+        for (int k = 0; k < MOVES; k++) {
+            total += weights[k];
+        }
+        for (int k = 0; k < MOVES; k++) {
+            probabilities_[k] = weights[k] / total;
+        }
+
+        /* Vose's construction: pair each underfull column with an
+           overfull one that tops it up */
+        std::vector<double> scaled(COLUMNS, 0.0);
+        std::vector<int> small, large;
+        for (int c = 0; c < COLUMNS; c++) {
+            scaled[c] = c < MOVES ? probabilities_[c] * COLUMNS : 0.0;
+            alias_[c] = c;
+            (scaled[c] < 1.0 ? small : large).push_back(c);
+        }
+        while (!small.empty() && !large.empty()) {
+            const int under = small.back();
+            small.pop_back();
+            const int over = large.back();
+            threshold_[under] = static_cast<std::uint32_t>(std::lround(scaled[under] * SCALE));
+            alias_[under] = over;
+            scaled[over] -= 1.0 - scaled[under];
+            if (scaled[over] < 1.0) {
+                large.pop_back();
+                small.push_back(over);
+            }
+        }
+
+        /* what is left is full up to rounding */
+        for (const int c : small) {
+            threshold_[c] = SCALE;
+        }
+        for (const int c : large) {
+            threshold_[c] = SCALE;
+        }
+    }
+
+    /* move for a uniform BITS-bit draw; branchless, since which way the
+       draw goes is a coin flip the predictor would miss */
+    int sample(const std::uint32_t draw) const {
+        const int column = static_cast<int>(draw >> (BITS - 4));
+        const int keep = -static_cast<int>((draw & (SCALE - 1)) < threshold_[column]);
+        return alias_[column] ^ ((column ^ alias_[column]) & keep);
+    }
+
+    double probability(const int move) const {
+        return probabilities_[move];
+    }
+
+    /* mean displacement of one move */
+    void drift(double& dx, double& dy) const {
+        dx = dy = 0;
+        for (int k = 0; k < MOVES; k++) {
+            dx += probabilities_[k] * (k / 3 - 1);
+            dy += probabilities_[k] * (k % 3 - 1);
+        }
+    }
+
+private:
+    std::vector<double> probabilities_;
+    std::uint32_t threshold_[COLUMNS];
+    int alias_[COLUMNS];
+};
+
+/**********************************************************************
+ * weights of the 9 moves for a neighborhood, per-move weights and a
+ * drift
+ *
+ * note: "moore" allows all 9 moves (staying put included, as in the
+ * uniform walk) and "neumann" only the 4 axis moves; each weight is
+ * then tilted by exp(driftX * dx + driftY * dy), so a drift of 0 leaves
+ * the walk unbiased and any drift keeps every allowed move possible
+***********************************************************************/
+inline std::vector<double> kernelWeights(const std::string& neighborhood, const std::vector<double>& weights, const double driftX, const double driftY) {
+    std::vector<double> result(MOVES);
+    for (int k = 0; k < MOVES; k++) {
+        const int dx = k / 3 - 1;
+        const int dy = k % 3 - 1;
+        const bool allowed = neighborhood == "moore" || std::abs(dx) + std::abs(dy) == 1;
+        result[k] = allowed ? (weights.empty() ? 1.0 : weights[k]) * std::exp(driftX * dx + driftY * dy) : 0.0;
+    }
+    return result;
+}
+
+/**********************************************************************
+ * moves drawn from a MoveKernel, three per 64-bit output of an engine,
+ * with the interface of MoveHarvester
+ *
+ * note: the top bit of each output is dropped
+***********************************************************************/
+template <typename G>
+class KernelMoves {
+public:
+    KernelMoves(const MoveKernel& kernel, G& engine) : kernel_(kernel), engine_(engine) {}
+
+    /* next move, 0 .. 8 */
+    int next() {
+        if (left_ == 0) {
+            word_ = engine_();
+            left_ = 3;
+        }
+        const int move = kernel_.sample(static_cast<std::uint32_t>(word_) & ((1u << MoveKernel::BITS) - 1));
+        word_ >>= MoveKernel::BITS;
+        left_--;
+        return move;
+    }
+
+    void next(int& dx, int& dy) {
+        const int move = next();
+        dx = move / 3 - 1;
+        dy = move % 3 - 1;
+    }
+
+private:
+    const MoveKernel& kernel_;
+    G& engine_;
+    std::uint64_t word_ = 0;
+    int left_ = 0;
+};
+
+/**********************************************************************
+ * prints a chi-square test of moves drawn from kernel against its
+ * probabilities, and its mean drift per move
+ *
+ * note: moves of probability 0 are left out and must never be drawn
+***********************************************************************/
+template <typename G>
+void checkKernel(const MoveKernel& kernel, G& generator, const long draws, std::ostream& out) {
+    KernelMoves<G> moves(kernel, generator);
+    std::vector<long> counts(MOVES, 0);
+    for (long i = 0; i < draws; i++) {
+        counts[moves.next()]++;
+    }
+    double chiSquare = 0;
+    int bins = 0;
+    long impossible = 0;
+    for (int k = 0; k < MOVES; k++) {
+        const double expected = draws * kernel.probability(k);
+        if (expected > 0) {
+            chiSquare += (counts[k] - expected) * (counts[k] - expected) / expected;
+            bins++;
+        } else {
+            impossible += counts[k];
+        }
+    }
+    double dx, dy;
+    kernel.drift(dx, dy);
+    out << "kernel moves: chi-square " << chiSquare << " on " << bins - 1 << " degrees of freedom, "
+        << impossible << " impossible moves, drift (" << dx << ", " << dy << ") per move" << std::endl;
+}
+
+#endif
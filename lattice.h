@@ -0,0 +1,779 @@
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+/**********************************************************************
+ * every lattice type provides the same small interface so the walk
+ * code can be written once as a template:
+ *
+ *   size()                 side length of the square domain
+ *   contains(x, y)         whether (x, y) lies inside the domain, for
+ *                          any cell at most one step outside it
+ *   occupied(x, y)         whether (x, y) is part of the crystal
+ *   touchesCrystal(x, y)   whether any of the 3x3 cells around (x, y)
+ *                          is part of the crystal
+ *   place(x, y)            adds (x, y) to the crystal
+ *
+ * reserveRadius(grid, r) must be called before any cell farther than
+ * r (max-norm) from the center can be placed; it is a no-op except for
+ * lattices that allocate lazily around the crystal
+ *
+ * note: cell loads and stores are relaxed atomics so parallel.cc can
+ * share the lattice between threads; on x86 these compile to plain
+ * moves, so sequential.cc pays nothing for them
+***********************************************************************/
+
+/* rounds value up to the next multiple of multiple */
+inline std::size_t roundUp(const std::size_t value, const std::size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+/**********************************************************************
+ * how lattice storage is allocated, set by main before any lattice
+ *
+ * note: with hugePages, allocations of at least one huge page are
+ * aligned to 2 MB and advised to use transparent huge pages; zero, if
+ * set, clears such allocations instead of the allocating thread, which
+ * decides the NUMA node each page lands on (first touch)
+***********************************************************************/
+struct AllocationPolicy {
+    static constexpr std::size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+    bool hugePages = false;
+    void (*zero)(char* bytes, std::size_t count) = nullptr;
+};
+
+inline AllocationPolicy& allocationPolicy() {
+    static AllocationPolicy policy;
+    return policy;
+}
+
+/* allocates zeroed, cache-line aligned storage for the lattice cells */
+inline void* allocateCells(const std::size_t bytes) {
+    const AllocationPolicy& policy = allocationPolicy();
+    const bool large = bytes >= AllocationPolicy::HUGE_PAGE;
+    const std::size_t alignment = policy.hugePages && large ? AllocationPolicy::HUGE_PAGE : 64;
+    void* cells = std::aligned_alloc(alignment, roundUp(bytes, alignment));
+    if (cells == nullptr) {
+        throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    if (alignment == AllocationPolicy::HUGE_PAGE) {
+        madvise(cells, roundUp(bytes, alignment), MADV_HUGEPAGE);
+    }
+#endif
+    if (policy.zero != nullptr && large) {
+        policy.zero(static_cast<char*>(cells), bytes);
+    } else {
+        std::memset(cells, 0, bytes);
+    }
+    return cells;
+}
+
+/**********************************************************************
+ * square lattice stored in one contiguous, cache-line aligned block
+ *
+ * note: cells are addressed as (x, y) with y varying fastest and every
+ * row padded to a whole number of cache lines, so the 3x3 neighborhood
+ * of a cell touches at most three adjacent rows and no row pointers
+***********************************************************************/
+class Lattice {
+public:
+    explicit Lattice(const int size)
+        : size_(size), stride_(roundUp(size, 64)),
+          cells_(static_cast<char*>(allocateCells(stride_ * size))) {}
+
+    ~Lattice() {
+        std::free(cells_);
+    }
+
+    Lattice(const Lattice&) = delete;
+    Lattice& operator=(const Lattice&) = delete;
+
+    int size() const {
+        return size_;
+    }
+
+    bool contains(const int x, const int y) const {
+        return x >= 0 && x < size_ && y >= 0 && y < size_;
+    }
+
+    bool occupied(const int x, const int y) const {
+        return __atomic_load_n(&cells_[index(x, y)], __ATOMIC_RELAXED) != 0;
+    }
+
+    bool touchesCrystal(const int x, const int y) const {
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                const int newX = x + dx;
+                const int newY = y + dy;
+                if (newX >= 0 && newX < size_ && newY >= 0 && newY < size_ && occupied(newX, newY)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void place(const int x, const int y) {
+        __atomic_store_n(&cells_[index(x, y)], 'X', __ATOMIC_RELAXED);
+    }
+
+    /* raw rows for vectorized readers; row x starts at cells() + x * stride() */
+    const char* cells() const {
+        return cells_;
+    }
+
+    std::size_t stride() const {
+        return stride_;
+    }
+
+private:
+    std::size_t index(const int x, const int y) const {
+        return static_cast<std::size_t>(x) * stride_ + static_cast<std::size_t>(y);
+    }
+
+    const int size_;
+    const std::size_t stride_;
+    char* const cells_;
+};
+
+/**********************************************************************
+ * square lattice packed one bit per cell, 64 cells per word
+ *
+ * note: each row carries a zero guard bit before and after its cells
+ * and the grid carries a zero guard row above and below, so the 3x3
+ * neighborhood test is three masked word loads with no bounds checks
+***********************************************************************/
+class BitLattice {
+public:
+    explicit BitLattice(const int size)
+        : size_(size), stride_((static_cast<std::size_t>(size) + 2 + 63) / 64),
+          words_(static_cast<std::uint64_t*>(allocateCells(stride_ * (size + 2) * sizeof(std::uint64_t)))) {}
+
+    ~BitLattice() {
+        std::free(words_);
+    }
+
+    BitLattice(const BitLattice&) = delete;
+    BitLattice& operator=(const BitLattice&) = delete;
+
+    int size() const {
+        return size_;
+    }
+
+    bool contains(const int x, const int y) const {
+        return x >= 0 && x < size_ && y >= 0 && y < size_;
+    }
+
+    bool occupied(const int x, const int y) const {
+        const std::size_t bit = static_cast<std::size_t>(y) + 1;
+        return (load(x, bit / 64) >> (bit % 64)) & 1;
+    }
+
+    bool touchesCrystal(const int x, const int y) const {
+        /* bits y - 1, y and y + 1 of each row start at guarded position y */
+        const std::size_t word = static_cast<std::size_t>(y) / 64;
+        const unsigned shift = static_cast<unsigned>(y) % 64;
+        for (int row = x - 1; row <= x + 1; row++) {
+            std::uint64_t bits = load(row, word) >> shift;
+            if (shift > 61) {
+                bits |= load(row, word + 1) << (64 - shift);
+            }
+            if (bits & 7) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void place(const int x, const int y) {
+        const std::size_t bit = static_cast<std::size_t>(y) + 1;
+        __atomic_fetch_or(&words_[offset(x, bit / 64)], std::uint64_t(1) << (bit % 64), __ATOMIC_RELAXED);
+    }
+
+private:
+    /* row x is stored at guarded row x + 1, so rows -1 and size are valid */
+    std::size_t offset(const int x, const std::size_t word) const {
+        return static_cast<std::size_t>(x + 1) * stride_ + word;
+    }
+
+    std::uint64_t load(const int x, const std::size_t word) const {
+        return __atomic_load_n(&words_[offset(x, word)], __ATOMIC_RELAXED);
+    }
+
+    const int size_;
+    const std::size_t stride_;
+    std::uint64_t* const words_;
+};
+
+/**********************************************************************
+ * lattice recording the order in which cells joined the crystal
+ *
+ * note: each cell holds a 32-bit attachment index (0 = empty, 1 = the
+ * seed) taken from an atomic counter at the moment of the store, so
+ * growth history can be analysed after the run; the layout otherwise
+ * matches Lattice
+***********************************************************************/
+class OrderLattice {
+public:
+    explicit OrderLattice(const int size)
+        : size_(size), stride_(roundUp(size, 16)), count_(0),
+          cells_(static_cast<std::uint32_t*>(allocateCells(stride_ * size * sizeof(std::uint32_t)))) {}
+
+    ~OrderLattice() {
+        std::free(cells_);
+    }
+
+    OrderLattice(const OrderLattice&) = delete;
+    OrderLattice& operator=(const OrderLattice&) = delete;
+
+    int size() const {
+        return size_;
+    }
+
+    bool contains(const int x, const int y) const {
+        return x >= 0 && x < size_ && y >= 0 && y < size_;
+    }
+
+    bool occupied(const int x, const int y) const {
+        return order(x, y) != 0;
+    }
+
+    bool touchesCrystal(const int x, const int y) const {
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                const int newX = x + dx;
+                const int newY = y + dy;
+                if (contains(newX, newY) && occupied(newX, newY)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void place(const int x, const int y) {
+        const std::uint32_t order = __atomic_add_fetch(&count_, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&cells_[index(x, y)], order, __ATOMIC_RELAXED);
+    }
+
+    /* attachment index of (x, y), 0 if empty */
+    std::uint32_t order(const int x, const int y) const {
+        return __atomic_load_n(&cells_[index(x, y)], __ATOMIC_RELAXED);
+    }
+
+private:
+    std::size_t index(const int x, const int y) const {
+        return static_cast<std::size_t>(x) * stride_ + static_cast<std::size_t>(y);
+    }
+
+    const int size_;
+    const std::size_t stride_;
+    std::uint32_t count_;
+    std::uint32_t* const cells_;
+};
+
+/**********************************************************************
+ * byte lattice that only stores a square window around the center,
+ * doubling the window as the crystal approaches its edge
+ *
+ * note: cells outside the window read as empty, so gridSize only
+ * bounds the walk and the window tracks the crystal; reserve() moves
+ * the cells to a new block and must not run concurrently with walkers
+***********************************************************************/
+class GrowingLattice {
+public:
+    static constexpr int INITIAL_HALF_WIDTH = 32;
+
+    explicit GrowingLattice(const int size)
+        : size_(size), center_(size / 2), halfWidth_(std::min(INITIAL_HALF_WIDTH, size / 2)),
+          side_(2 * halfWidth_ + 1), cells_(static_cast<char*>(allocateCells(side_ * side_))) {}
+
+    ~GrowingLattice() {
+        std::free(cells_);
+    }
+
+    GrowingLattice(const GrowingLattice&) = delete;
+    GrowingLattice& operator=(const GrowingLattice&) = delete;
+
+    int size() const {
+        return size_;
+    }
+
+    /* current half width of the stored window around the center */
+    int halfWidth() const {
+        return halfWidth_;
+    }
+
+    bool contains(const int x, const int y) const {
+        return x >= 0 && x < size_ && y >= 0 && y < size_;
+    }
+
+    bool occupied(const int x, const int y) const {
+        return inWindow(x, y) && __atomic_load_n(&cells_[index(x, y)], __ATOMIC_RELAXED) != 0;
+    }
+
+    bool touchesCrystal(const int x, const int y) const {
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                if (occupied(x + dx, y + dy)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void place(const int x, const int y) {
+        __atomic_store_n(&cells_[index(x, y)], 'X', __ATOMIC_RELAXED);
+    }
+
+    /* grows the window, at least doubling it, until it covers radius */
+    void reserve(const int radius) {
+        if (radius <= halfWidth_ || halfWidth_ == size_ / 2) {
+            return;
+        }
+        const int halfWidth = std::min(std::max(2 * halfWidth_, radius), size_ / 2);
+        const std::size_t side = 2 * halfWidth + 1;
+        char* cells = static_cast<char*>(allocateCells(side * side));
+        const std::size_t shift = halfWidth - halfWidth_;
+        for (std::size_t row = 0; row < side_; row++) {
+            std::memcpy(&cells[(row + shift) * side + shift], &cells_[row * side_], side_);
+        }
+        std::free(cells_);
+        cells_ = cells;
+        halfWidth_ = halfWidth;
+        side_ = side;
+    }
+
+private:
+    bool inWindow(const int x, const int y) const {
+        return std::abs(x - center_) <= halfWidth_ && std::abs(y - center_) <= halfWidth_;
+    }
+
+    std::size_t index(const int x, const int y) const {
+        return static_cast<std::size_t>(x - center_ + halfWidth_) * side_ + static_cast<std::size_t>(y - center_ + halfWidth_);
+    }
+
+    const int size_;
+    const int center_;
+    int halfWidth_;
+    std::size_t side_;
+    char* cells_;
+};
+
+/**********************************************************************
+ * byte lattice surrounded by a one cell halo of absorbing sentinels
+ *
+ * note: a walker moves at most one cell per step, so it can only leave
+ * the domain by landing on the halo; contains() and touchesCrystal()
+ * are therefore plain loads with no bounds checks
+***********************************************************************/
+class PaddedLattice {
+public:
+    static constexpr char ABSORBING = '#';
+
+    explicit PaddedLattice(const int size)
+        : size_(size), stride_(roundUp(size + 2, 64)),
+          cells_(static_cast<char*>(allocateCells(stride_ * (size + 2)))) {
+        for (int i = -1; i <= size; i++) {
+            cells_[index(-1, i)] = ABSORBING;
+            cells_[index(size, i)] = ABSORBING;
+            cells_[index(i, -1)] = ABSORBING;
+            cells_[index(i, size)] = ABSORBING;
+        }
+    }
+
+    ~PaddedLattice() {
+        std::free(cells_);
+    }
+
+    PaddedLattice(const PaddedLattice&) = delete;
+    PaddedLattice& operator=(const PaddedLattice&) = delete;
+
+    int size() const {
+        return size_;
+    }
+
+    bool contains(const int x, const int y) const {
+        return load(x, y) != ABSORBING;
+    }
+
+    bool occupied(const int x, const int y) const {
+        return load(x, y) == 'X';
+    }
+
+    bool touchesCrystal(const int x, const int y) const {
+        /* row above, own row and row below, each three adjacent bytes */
+        const char* row = &cells_[index(x - 1, y - 1)];
+        for (int dx = 0; dx < 3; dx++, row += stride_) {
+            if ((__atomic_load_n(&row[0], __ATOMIC_RELAXED) == 'X') |
+                (__atomic_load_n(&row[1], __ATOMIC_RELAXED) == 'X') |
+                (__atomic_load_n(&row[2], __ATOMIC_RELAXED) == 'X')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void place(const int x, const int y) {
+        __atomic_store_n(&cells_[index(x, y)], 'X', __ATOMIC_RELAXED);
+    }
+
+private:
+    /* cell (x, y) is stored at padded position (x + 1, y + 1) */
+    std::size_t index(const int x, const int y) const {
+        return static_cast<std::size_t>(x + 1) * stride_ + static_cast<std::size_t>(y + 1);
+    }
+
+    char load(const int x, const int y) const {
+        return __atomic_load_n(&cells_[index(x, y)], __ATOMIC_RELAXED);
+    }
+
+    const int size_;
+    const std::size_t stride_;
+    char* const cells_;
+};
+
+/**********************************************************************
+ * byte lattice stored in Morton (Z-order) layout
+ *
+ * note: y occupies the even bits of a cell's index and x the odd bits,
+ * so cells that are close in both directions share cache lines and
+ * pages; neighbor indices are formed by adding directly on the
+ * interleaved ("dilated") coordinates. The side is rounded up to a
+ * power of two, e.g. 16001 is stored as 16384 x 16384.
+***********************************************************************/
+class MortonLattice {
+public:
+    explicit MortonLattice(const int size)
+        : size_(size), side_(powerOfTwo(size)),
+          cells_(static_cast<char*>(allocateCells(side_ * side_))) {}
+
+    ~MortonLattice() {
+        std::free(cells_);
+    }
+
+    MortonLattice(const MortonLattice&) = delete;
+    MortonLattice& operator=(const MortonLattice&) = delete;
+
+    int size() const {
+        return size_;
+    }
+
+    bool contains(const int x, const int y) const {
+        return x >= 0 && x < size_ && y >= 0 && y < size_;
+    }
+
+    bool occupied(const int x, const int y) const {
+        return load(dilate(x) << 1 | dilate(y));
+    }
+
+    bool touchesCrystal(const int x, const int y) const {
+        const std::uint64_t dx = dilate(x) << 1;
+        const std::uint64_t dy = dilate(y);
+        const std::uint64_t rows[3] = {((dx & X_BITS) - 2) & X_BITS, dx, ((dx | Y_BITS) + 2) & X_BITS};
+        const std::uint64_t columns[3] = {((dy & Y_BITS) - 1) & Y_BITS, dy, ((dy | X_BITS) + 1) & Y_BITS};
+        for (int i = 0; i < 3; i++) {
+            const int newX = x + i - 1;
+            if (newX < 0 || newX >= size_) {
+                continue;
+            }
+            for (int k = 0; k < 3; k++) {
+                const int newY = y + k - 1;
+                if (newY >= 0 && newY < size_ && load(rows[i] | columns[k])) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void place(const int x, const int y) {
+        __atomic_store_n(&cells_[dilate(x) << 1 | dilate(y)], 'X', __ATOMIC_RELAXED);
+    }
+
+private:
+    static constexpr std::uint64_t X_BITS = 0xAAAAAAAAAAAAAAAAull;
+    static constexpr std::uint64_t Y_BITS = 0x5555555555555555ull;
+
+    static std::size_t powerOfTwo(const int size) {
+        std::size_t side = 1;
+        while (side < static_cast<std::size_t>(size)) {
+            side <<= 1;
+        }
+        return side;
+    }
+
+    /* spreads the bits of value so bit i moves to bit 2i */
+    static std::uint64_t dilate(const int value) {
+        std::uint64_t bits = static_cast<std::uint32_t>(value);
+        bits = (bits | bits << 16) & 0x0000FFFF0000FFFFull;
+        bits = (bits | bits << 8) & 0x00FF00FF00FF00FFull;
+        bits = (bits | bits << 4) & 0x0F0F0F0F0F0F0F0Full;
+        bits = (bits | bits << 2) & 0x3333333333333333ull;
+        bits = (bits | bits << 1) & 0x5555555555555555ull;
+        return bits;
+    }
+
+    bool load(const std::uint64_t index) const {
+        return __atomic_load_n(&cells_[index], __ATOMIC_RELAXED) != 0;
+    }
+
+    const int size_;
+    const std::size_t side_;
+    char* const cells_;
+};
+
+/**********************************************************************
+ * sparse byte lattice made of 64x64 chunks allocated on first write
+ *
+ * note: chunks are found through a two level directory (blocks of
+ * 64x64 chunk pointers) rather than a hash map, so lookups need no
+ * locks and a new chunk or block is published with a single
+ * compare-and-swap. Reads in untouched space stop at a null pointer,
+ * and a cell away from its chunk's edge checks its whole neighborhood
+ * with one chunk lookup.
+***********************************************************************/
+class SparseLattice {
+public:
+    static constexpr int CHUNK = 64;
+    static constexpr int BLOCK = 64;
+
+    explicit SparseLattice(const int size)
+        : size_(size), blocksPerSide_((static_cast<std::size_t>(size) + CHUNK * BLOCK - 1) / (CHUNK * BLOCK)),
+          blocks_(static_cast<char***>(allocateCells(blocksPerSide_ * blocksPerSide_ * sizeof(char**)))) {}
+
+    ~SparseLattice() {
+        for (std::size_t b = 0; b < blocksPerSide_ * blocksPerSide_; b++) {
+            if (blocks_[b] != nullptr) {
+                for (int c = 0; c < BLOCK * BLOCK; c++) {
+                    std::free(blocks_[b][c]);
+                }
+                std::free(blocks_[b]);
+            }
+        }
+        std::free(blocks_);
+    }
+
+    SparseLattice(const SparseLattice&) = delete;
+    SparseLattice& operator=(const SparseLattice&) = delete;
+
+    int size() const {
+        return size_;
+    }
+
+    bool contains(const int x, const int y) const {
+        return x >= 0 && x < size_ && y >= 0 && y < size_;
+    }
+
+    bool occupied(const int x, const int y) const {
+        const char* chunk = findChunk(x, y);
+        return chunk != nullptr && load(chunk, x, y);
+    }
+
+    bool touchesCrystal(const int x, const int y) const {
+        const int cx = x % CHUNK;
+        const int cy = y % CHUNK;
+        if (cx > 0 && cx < CHUNK - 1 && cy > 0 && cy < CHUNK - 1) {
+            /* whole neighborhood lies inside one chunk */
+            const char* chunk = findChunk(x, y);
+            if (chunk == nullptr) {
+                return false;
+            }
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    if (load(chunk, x + dx, y + dy)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                const int newX = x + dx;
+                const int newY = y + dy;
+                if (contains(newX, newY) && occupied(newX, newY)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void place(const int x, const int y) {
+        char** block = publish(&blocks_[blockIndex(x, y)], BLOCK * BLOCK * sizeof(char*));
+        char* chunk = publish(&block[chunkIndex(x, y)], CHUNK * CHUNK);
+        __atomic_store_n(&chunk[cellIndex(x, y)], 'X', __ATOMIC_RELAXED);
+    }
+
+private:
+    std::size_t blockIndex(const int x, const int y) const {
+        return static_cast<std::size_t>(x / (CHUNK * BLOCK)) * blocksPerSide_ + y / (CHUNK * BLOCK);
+    }
+
+    static int chunkIndex(const int x, const int y) {
+        return (x / CHUNK % BLOCK) * BLOCK + y / CHUNK % BLOCK;
+    }
+
+    static int cellIndex(const int x, const int y) {
+        return (x % CHUNK) * CHUNK + y % CHUNK;
+    }
+
+    static bool load(const char* chunk, const int x, const int y) {
+        return __atomic_load_n(&chunk[cellIndex(x, y)], __ATOMIC_RELAXED) != 0;
+    }
+
+    /* returns the chunk holding (x, y), or nullptr if never written */
+    const char* findChunk(const int x, const int y) const {
+        char** block = __atomic_load_n(&blocks_[blockIndex(x, y)], __ATOMIC_ACQUIRE);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        return __atomic_load_n(&block[chunkIndex(x, y)], __ATOMIC_ACQUIRE);
+    }
+
+    /* returns *slot, first installing zeroed storage of bytes if null */
+    template <typename T>
+    static T* publish(T** slot, const std::size_t bytes) {
+        T* current = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (current != nullptr) {
+            return current;
+        }
+        T* fresh = static_cast<T*>(allocateCells(bytes));
+        if (__atomic_compare_exchange_n(slot, &current, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return fresh;
+        }
+        /* another thread installed it first */
+        std::free(fresh);
+        return current;
+    }
+
+    const int size_;
+    const std::size_t blocksPerSide_;
+    char*** const blocks_;
+};
+
+/**********************************************************************
+ * lattice of type L paired with a dilation mask of the crystal
+ *
+ * note: the mask marks every cell within the 3x3 neighborhood of a
+ * crystal cell, so touchesCrystal is a single load; place updates the
+ * nine mask cells with the same atomic stores the lattice uses
+***********************************************************************/
+template <typename L>
+class StickyLattice {
+public:
+    explicit StickyLattice(const int size) : crystal_(size), mask_(size) {}
+
+    int size() const {
+        return crystal_.size();
+    }
+
+    bool contains(const int x, const int y) const {
+        return crystal_.contains(x, y);
+    }
+
+    bool occupied(const int x, const int y) const {
+        return crystal_.occupied(x, y);
+    }
+
+    const L& crystal() const {
+        return crystal_;
+    }
+
+    L& crystal() {
+        return crystal_;
+    }
+
+    const L& mask() const {
+        return mask_;
+    }
+
+    L& mask() {
+        return mask_;
+    }
+
+    bool touchesCrystal(const int x, const int y) const {
+        return mask_.occupied(x, y);
+    }
+
+    void place(const int x, const int y) {
+        crystal_.place(x, y);
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                const int newX = x + dx;
+                const int newY = y + dy;
+                if (crystal_.contains(newX, newY)) {
+                    mask_.place(newX, newY);
+                }
+            }
+        }
+    }
+
+private:
+    L crystal_;
+    L mask_;
+};
+
+/* makes room for crystal cells up to radius from the center */
+template <typename L>
+void reserveRadius(L&, const int) {}
+
+inline void reserveRadius(GrowingLattice& grid, const int radius) {
+    grid.reserve(radius);
+}
+
+template <typename L>
+void reserveRadius(StickyLattice<L>& grid, const int radius) {
+    /* the mask extends one cell past the crystal */
+    reserveRadius(grid.crystal(), radius);
+    reserveRadius(grid.mask(), radius + 1);
+}
+
+/* whether reserveRadius can move cells, so walkers must pause for it */
+template <typename L>
+bool growsLazily(const L&) {
+    return false;
+}
+
+inline bool growsLazily(const GrowingLattice&) {
+    return true;
+}
+
+template <typename L>
+bool growsLazily(const StickyLattice<L>& grid) {
+    return growsLazily(grid.crystal());
+}
+
+/**********************************************************************
+ * value written to the result file for (x, y)
+ *
+ * note: 1 for crystal cells and 0 otherwise, except on an OrderLattice
+ * where it is the cell's attachment index
+***********************************************************************/
+template <typename L>
+std::uint32_t cellValue(const L& grid, const int x, const int y) {
+    return grid.occupied(x, y) ? 1 : 0;
+}
+
+inline std::uint32_t cellValue(const OrderLattice& grid, const int x, const int y) {
+    return grid.order(x, y);
+}
+
+template <typename L>
+std::uint32_t cellValue(const StickyLattice<L>& grid, const int x, const int y) {
+    return cellValue(grid.crystal(), x, y);
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <cmath>
+#include <random>
+#include <tuple>
+
+/* gap between the crystal's bounding circle and the launch circle */
+const double LAUNCH_GAP = 3.0;
+
+/**********************************************************************
+ * radius of the launch circle for a crystal of max-norm radius radius
+ *
+ * note: the crystal lies within max-norm distance radius of the center,
+ * so within Euclidean distance radius * sqrt(2); the gap keeps a point
+ * rounded onto the lattice from starting next to the crystal
+***********************************************************************/
+inline double launchRadius(const int radius) {
+    return radius * std::sqrt(2.0) + LAUNCH_GAP;
+}
+
+/* whether a circle of the given radius around center lies inside the lattice */
+inline bool circleFits(const int center, const double radius) {
+    return radius + 1 < center;
+}
+
+/**********************************************************************
+ * generates a point at a uniformly random angle on the circle of the
+ * given radius around (center, center), rounded to the lattice
+***********************************************************************/
+template <typename G>
+std::tuple<int, int> pointOnCircle(G& generator, const int center, const double radius) {
+    std::uniform_real_distribution<double> distribution(0.0, 2.0 * M_PI);
+    const double angle = distribution(generator);
+    const int x = center + static_cast<int>(std::lround(radius * std::cos(angle)));
+    const int y = center + static_cast<int>(std::lround(radius * std::sin(angle)));
+    return std::make_tuple(x, y);
+}
+
+/**********************************************************************
+ * circle beyond which a walker is returned to the launch circle
+ *
+ * note: from distance rho > R, the point where a walker first reaches
+ * the circle of radius R around the center follows the harmonic
+ * measure, a wrapped Cauchy distribution in angle centered on the
+ * walker's own angle with concentration R / rho; sampling it directly
+ * cuts off long excursions exactly and discards no particle
+***********************************************************************/
+struct KillCircle {
+    int center;
+    double launchRadius;
+    double killRadius;
+
+    bool outside(const double x, const double y) const {
+        const double dx = x - center;
+        const double dy = y - center;
+        return dx * dx + dy * dy > killRadius * killRadius;
+    }
+
+    /* angle at which a walker at (x, y) first reaches the launch circle */
+    template <typename G>
+    double returnAngle(G& generator, const double x, const double y) const {
+        const double dx = x - center;
+        const double dy = y - center;
+        const double ratio = launchRadius / std::sqrt(dx * dx + dy * dy);
+        std::uniform_real_distribution<double> distribution(-0.5, 0.5);
+        const double offset = 2.0 * std::atan((1.0 - ratio) / (1.0 + ratio) * std::tan(M_PI * distribution(generator)));
+        return std::atan2(dy, dx) + offset;
+    }
+
+    template <typename G>
+    void returnWalker(G& generator, int& x, int& y) const {
+        const double angle = returnAngle(generator, x, y);
+        x = center + static_cast<int>(std::lround(launchRadius * std::cos(angle)));
+        y = center + static_cast<int>(std::lround(launchRadius * std::sin(angle)));
+    }
+
+    /* the same for a walker in continuous space */
+    template <typename G>
+    void returnWalker(G& generator, double& x, double& y) const {
+        const double angle = returnAngle(generator, x, y);
+        x = center + launchRadius * std::cos(angle);
+        y = center + launchRadius * std::sin(angle);
+    }
+};
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef OFFLATTICE_H
+#define OFFLATTICE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+#include "lattice.h"
+#include "launch.h"
+
+/* length of a walk step next to the cluster, in disk diameters */
+const double DISK_STEP = 1.0;
+
+/**********************************************************************
+ * cluster of stuck unit-diameter disks in the continuous square
+ * [0, size) x [0, size), indexed by a uniform cell list
+ *
+ * note: disk i sits in the cell containing its center; each cell heads
+ * a singly linked list of disk indexes (stored plus one, so the zeroed
+ * allocation is an empty list). add() writes the center, raises the
+ * radius (the largest distance from the center of the domain to a disk
+ * center) with a release compare-and-swap loop and only then publishes
+ * the disk with a release compare-and-swap on the cell head, so
+ * concurrent readers see either a complete disk or none, and every disk
+ * they can see lies within radius().
+***********************************************************************/
+class DiskCluster {
+public:
+    /* cell side; the 3x3 cells around a point cover every disk within CELL */
+    static constexpr double CELL = 2.0;
+
+    /* rings of cells searched by nearest() before falling back to a bound */
+    static constexpr int RINGS = 4;
+
+    DiskCluster(const int size, const std::size_t capacity)
+        : size_(size), side_(static_cast<int>(std::ceil(size / CELL))), capacity_(capacity),
+          heads_(static_cast<std::uint32_t*>(allocateCells(static_cast<std::size_t>(side_) * side_ * sizeof(std::uint32_t)))),
+          next_(static_cast<std::uint32_t*>(allocateCells(capacity * sizeof(std::uint32_t)))),
+          x_(static_cast<double*>(allocateCells(capacity * sizeof(double)))),
+          y_(static_cast<double*>(allocateCells(capacity * sizeof(double)))) {}
+
+    ~DiskCluster() {
+        std::free(heads_);
+        std::free(next_);
+        std::free(x_);
+        std::free(y_);
+    }
+
+    DiskCluster(const DiskCluster&) = delete;
+    DiskCluster& operator=(const DiskCluster&) = delete;
+
+    int size() const {
+        return size_;
+    }
+
+    /* center of the domain, the lattice center for an odd size */
+    double center() const {
+        return size_ / 2;
+    }
+
+    /* whether the point lies inside the domain */
+    bool contains(const double x, const double y) const {
+        return x >= 0 && x < size_ && y >= 0 && y < size_;
+    }
+
+    /* number of disks in the cluster */
+    std::size_t count() const {
+        return std::min(__atomic_load_n(&count_, __ATOMIC_ACQUIRE), capacity_);
+    }
+
+    double x(const std::size_t i) const {
+        return x_[i];
+    }
+
+    double y(const std::size_t i) const {
+        return y_[i];
+    }
+
+    /* largest distance from the center of the domain to a disk center */
+    double radius() const {
+        double radius;
+        __atomic_load(&radius_, &radius, __ATOMIC_ACQUIRE);
+        return radius;
+    }
+
+    /* adds a disk centered at (x, y); returns false once capacity is reached */
+    bool add(const double x, const double y) {
+        const std::size_t i = __atomic_fetch_add(&count_, 1, __ATOMIC_ACQ_REL);
+        if (i >= capacity_) {
+            return false;
+        }
+        x_[i] = x;
+        y_[i] = y;
+
+        /* raise the radius first, so a walker never finds the disk in the
+           cell list while radius() still leaves it out */
+        const double distance = std::hypot(x - center(), y - center());
+        double radius = this->radius();
+        while (distance > radius && !__atomic_compare_exchange(&radius_, &radius, &distance, true, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+        }
+
+        std::uint32_t* head = &heads_[cell(x, y)];
+        next_[i] = __atomic_load_n(head, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(head, &next_[i], static_cast<std::uint32_t>(i + 1), true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+        return true;
+    }
+
+    /**********************************************************************
+     * lower bound on the distance from (x, y) to the nearest disk center
+     *
+     * note: after scanning the rings of cells up to max-norm offset k,
+     * every center closer than k * CELL has been seen; the search stops
+     * once the closest one found is within that distance, or after
+     * RINGS rings with the bound RINGS * CELL
+    ***********************************************************************/
+    double nearest(const double x, const double y) const {
+        const int cx = static_cast<int>(x / CELL);
+        const int cy = static_cast<int>(y / CELL);
+        double best = RINGS * CELL;
+        for (int ring = 0; ring <= RINGS; ring++) {
+            for (int dx = -ring; dx <= ring; dx++) {
+                const int step = dx == -ring || dx == ring ? 1 : 2 * ring;
+                for (int dy = -ring; dy <= ring; dy += step) {
+                    forEach(cx + dx, cy + dy, [&](const std::uint32_t i) {
+                        best = std::min(best, std::hypot(x - x_[i], y - y_[i]));
+                    });
+                }
+            }
+            if (best <= ring * CELL) {
+                break;
+            }
+        }
+        return best;
+    }
+
+    /**********************************************************************
+     * distance along the unit vector (ux, uy) from (x, y) at which a disk
+     * moving that way first touches the cluster, -1 if not within length
+     *
+     * note: solves |p + t u - c| = 1 for each center c in the 3x3 cells,
+     * which cover every disk a move of length <= CELL - 1 can reach
+    ***********************************************************************/
+    double contact(const double x, const double y, const double ux, const double uy, const double length) const {
+        const int cx = static_cast<int>(x / CELL);
+        const int cy = static_cast<int>(y / CELL);
+        double best = -1;
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                forEach(cx + dx, cy + dy, [&](const std::uint32_t i) {
+                    const double wx = x - x_[i];
+                    const double wy = y - y_[i];
+                    const double b = ux * wx + uy * wy;
+                    const double c = wx * wx + wy * wy - 1.0;
+                    double t = -1;
+                    if (c <= 0) {
+                        t = 0;
+                    } else if (b < 0 && b * b >= c) {
+                        t = -b - std::sqrt(b * b - c);
+                    }
+                    if (t >= 0 && t <= length && (best < 0 || t < best)) {
+                        best = t;
+                    }
+                });
+            }
+        }
+        return best;
+    }
+
+private:
+    std::size_t cell(const double x, const double y) const {
+        return static_cast<std::size_t>(static_cast<int>(x / CELL)) * side_ + static_cast<int>(y / CELL);
+    }
+
+    /* calls visit with the index of every disk in cell (cx, cy) */
+    template <typename F>
+    void forEach(const int cx, const int cy, F visit) const {
+        if (cx < 0 || cx >= side_ || cy < 0 || cy >= side_) {
+            return;
+        }
+        std::uint32_t i = __atomic_load_n(&heads_[static_cast<std::size_t>(cx) * side_ + cy], __ATOMIC_ACQUIRE);
+        while (i != 0) {
+            visit(i - 1);
+            i = next_[i - 1];
+        }
+    }
+
+    const int size_;
+    const int side_;
+    const std::size_t capacity_;
+    std::size_t count_ = 0;
+    double radius_ = 0;
+    std::uint32_t* heads_;
+    std::uint32_t* next_;
+    double* x_;
+    double* y_;
+};
+
+/**********************************************************************
+ * places (x, y) at a uniformly random angle on the circle of the given
+ * radius around (center, center)
+***********************************************************************/
+template <typename G>
+void diskOnCircle(G& generator, const double center, const double radius, double& x, double& y) {
+    std::uniform_real_distribution<double> distribution(0.0, 2.0 * M_PI);
+    const double angle = distribution(generator);
+    x = center + radius * std::cos(angle);
+    y = center + radius * std::sin(angle);
+}
+
+/**********************************************************************
+ * walks a disk until it touches the cluster or leaves the domain
+ *
+ * note: the disk jumps to a uniformly random point on the largest
+ * circle known to be free of contacts (walk-on-spheres), bounded by the
+ * cluster radius, the cell list and the domain edge; once that circle
+ * is shorter than DISK_STEP it moves DISK_STEP in a random direction
+ * and stops at the exact point of contact along the way. Returns
+ * whether the disk stuck, leaving (x, y) at its contact position.
+***********************************************************************/
+template <typename G>
+bool walkDisk(G& generator, const DiskCluster& cluster, const KillCircle* kill, double& x, double& y) {
+    std::uniform_real_distribution<double> distribution(0.0, 2.0 * M_PI);
+    const double center = cluster.center();
+    while (cluster.contains(x, y)) {
+        /* return strays to the launch circle */
+        if (kill != nullptr && kill->outside(x, y)) {
+            kill->returnWalker(generator, x, y);
+            continue;
+        }
+
+        const double far = std::hypot(x - center, y - center) - cluster.radius();
+        const double edge = std::min(std::min(x, cluster.size() - x), std::min(y, cluster.size() - y));
+        const double reach = std::min(std::max(far, cluster.nearest(x, y)) - 1.0, edge);
+        const double angle = distribution(generator);
+        if (reach >= DISK_STEP) {
+            x += reach * std::cos(angle);
+            y += reach * std::sin(angle);
+            continue;
+        }
+
+        const double ux = std::cos(angle);
+        const double uy = std::sin(angle);
+        const double t = cluster.contact(x, y, ux, uy, DISK_STEP);
+        if (t >= 0) {
+            x += t * ux;
+            y += t * uy;
+            return true;
+        }
+        x += DISK_STEP * ux;
+        y += DISK_STEP * uy;
+    }
+    return false;
+}
+
+/**********************************************************************
+ * launches a disk on the circle of the given radius around the center
+ * and walks it, adding it to the cluster if it sticks
+ *
+ * note: strays beyond kill times the launch radius are returned to the
+ * launch circle if kill > 1 and that circle fits
+***********************************************************************/
+template <typename G>
+void runDisk(G& generator, DiskCluster& cluster, const int center, const double launch, const double kill) {
+    const KillCircle circle = {center, launch, kill * launch};
+    const bool killing = kill > 1 && circleFits(center, circle.killRadius);
+
+    double x, y;
+    diskOnCircle(generator, center, launch, x, y);
+    if (walkDisk(generator, cluster, killing ? &circle : nullptr, x, y)) {
+        cluster.add(x, y);
+    }
+}
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "kernel.h"
+
+/**********************************************************************
+ * optional settings that follow <grid_size> <num_particles>
+***********************************************************************/
+struct Options {
+    /* growth model: "lattice" (walkers step between lattice cells) or
+       "offlattice" (unit-diameter disks in continuous space, written
+       rasterized onto the lattice) */
+    std::string model = "lattice";
+
+    /* lattice storage: "char" (one byte per cell), "bits" (one bit),
+       "padded" (one byte per cell inside a halo of absorbing cells),
+       "morton" (one byte per cell in Z-order), "sparse" (64x64 byte
+       chunks allocated on first write), "order" (the 32-bit
+       attachment index of each cell) or "growing" (a window around
+       the center that doubles as the crystal grows) */
+    std::string lattice = "char";
+
+    /* maintain a dilation mask so the sticking test is one load */
+    bool sticky = false;
+
+    /* maintain an occupancy pyramid and skip sticking tests inside
+       squares it proves empty */
+    bool pyramid = false;
+
+    /* back large lattices with transparent huge pages */
+    bool hugePages = false;
+
+    /* zero lattices from every thread so pages spread over NUMA nodes
+       (parallel binary only) */
+    bool parallelTouch = false;
+
+    /* where walkers start: "square" (uniformly over the lattice outside
+       the crystal's bounding square) or "circle" (on a circle just
+       outside the crystal) */
+    std::string inject = "square";
+
+    /* how walkers move: "step" (one lattice step at a time), "jump"
+       (walk-on-spheres jumps across empty space far from the crystal)
+       "hop" (2^k steps at once from exact displacement tables) or
+       "square" (to the exit point of the largest empty square) */
+    std::string walk = "step";
+
+    /* kill circle radius as a multiple of the launch circle radius, 0
+       to let walkers run until they leave the lattice */
+    double kill = 0;
+
+    /* maintain the distance from every cell to the crystal, capped at
+       DistanceField::CAP, and use it to size jumps */
+    bool distance = false;
+
+    /* walkers advanced in lockstep, 0 to walk one particle at a time
+       (sequential binary only; batches take single steps) */
+    unsigned long batch = 0;
+
+    /* instruction set of the batch kernel: "auto" (the best the CPU
+       supports), "scalar", "avx2" or "avx512" */
+    std::string simd = "auto";
+
+    /* time the batch kernels and move sources (sequential binary) or
+       shared radius updates (parallel binary) before running */
+    bool benchmark = false;
+
+    /* write only the square around the crystal instead of the lattice */
+    bool crop = false;
+
+    /* print statistical checks of the walk tables before running */
+    bool check = false;
+
+    /* run seed; particle i walks on Philox stream i of this key, and a
+       seeded parallel run grows the crystal the sequential one does */
+    bool seeded = false;
+    std::uint64_t seed = 0;
+
+    /* random engines: "philox" (a counter-based stream per particle) or
+       "xoshiro" (one xoshiro256** engine per thread, each jumped 2^128
+       outputs past the previous thread's, drawn from by its particles
+       in turn) */
+    std::string rng = "philox";
+
+    /* print the seed of every engine before running */
+    bool logSeeds = false;
+
+    /* give every walker thread a producer thread that fills a ring with
+       its lattice steps ahead of time */
+    bool producers = false;
+
+    /* moves a walker may take: "moore" (the 8 neighbors or staying put)
+       or "neumann" (the 4 axis neighbors) */
+    std::string moves = "moore";
+
+    /* bias of the moves, exp(driftX * dx + driftY * dy) */
+    double driftX = 0;
+    double driftY = 0;
+
+    /* weight of each move k (dx = k / 3 - 1, dy = k % 3 - 1), empty for
+       equal weights */
+    std::vector<double> weights;
+};
+
+/* whether the walk draws from a MoveKernel rather than the uniform 9 moves */
+inline bool biasedWalk(const Options& options) {
+    return options.moves != "moore" || options.driftX != 0 || options.driftY != 0 || !options.weights.empty();
+}
+
+/* usage text for the optional arguments, shared by both binaries */
+const char* const OPTIONS_USAGE =
+    "\t--model=lattice|offlattice\tgrow on the lattice or from disks in continuous space\n"
+    "\t--lattice=char|bits|padded|morton|sparse|order|growing\tlattice storage (default char)\n"
+    "\t--sticky\t\tmaintain a mask of cells adjacent to the crystal\n"
+    "\t--inject=square|circle\twhere walkers start (default square)\n"
+    "\t--walk=step|jump|hop|square\thow walkers cross empty space (default step)\n"
+    "\t--kill=<factor>\t\treturn walkers beyond factor * launch radius to the launch circle\n"
+    "\t--pyramid\t\tskip sticking tests inside squares known to be empty\n"
+    "\t--distance\t\tmaintain a distance field of the crystal to size jumps\n"
+    "\t--huge-pages\t\tback large lattices with transparent huge pages\n"
+    "\t--first-touch=main|parallel\tthread(s) that first touch lattice pages\n"
+    "\t--batch=<walkers>\tadvance walkers in lockstep batches (sequential binary)\n"
+    "\t--simd=auto|scalar|avx2|avx512\tinstruction set of the batch kernel (default auto)\n"
+    "\t--benchmark\t\ttime batch kernels and move sources, or radius updates\n"
+    "\t--crop\t\t\twrite only the bounding square of the crystal\n"
+    "\t--check\t\t\tprint statistical checks of the walk tables\n"
+    "\t--seed=<n>\t\treproducible run from seed n (default from the clock)\n"
+    "\t--rng=philox|xoshiro\tper-particle streams or per-thread engines (default philox)\n"
+    "\t--log-seeds\t\tprint the seed of every engine\n"
+    "\t--producers\t\tdraw lattice steps on producer threads ahead of the walkers\n"
+    "\t--moves=moore|neumann\tneighbors a walker may step to (default moore)\n"
+    "\t--drift=<dx>,<dy>\tbias steps by exp(dx * x + dy * y)\n"
+    "\t--weights=<w0>,...,<w8>\tweight of each of the 9 moves\n";
+
+/**********************************************************************
+ * parses the optional --name[=value] arguments starting at argv[first]
+ *
+ * note: prints the offending argument and returns false on error;
+ * parallel rejects the options only the sequential binary implements
+***********************************************************************/
+inline bool parseOptions(const int argc, char* argv[], const int first, const bool parallel, Options& options) {
+    const std::regex pattern("--([a-z-]+)(=(.*))?");
+    for (int i = first; i < argc; i++) {
+        const std::string arg = argv[i];
+        std::smatch match;
+        if (!std::regex_match(arg, match, pattern)) {
+            std::cerr << "Unrecognized argument: " << arg << std::endl;
+            return false;
+        }
+        const std::string name = match[1];
+        const std::string value = match[3];
+        if (parallel && (name == "batch" || name == "simd")) {
+            std::cerr << "Option not supported by the parallel binary: " << arg << std::endl;
+            return false;
+        } else if (name == "model" && (value == "lattice" || value == "offlattice")) {
+            options.model = value;
+        } else if (name == "lattice" && (value == "char" || value == "bits" || value == "padded" || value == "morton" || value == "sparse" || value == "order" || value == "growing")) {
+            options.lattice = value;
+        } else if (name == "sticky" && !match[2].matched) {
+            options.sticky = true;
+        } else if (name == "inject" && (value == "square" || value == "circle")) {
+            options.inject = value;
+        } else if (name == "walk" && (value == "step" || value == "jump" || value == "hop" || value == "square")) {
+            options.walk = value;
+        } else if (name == "kill" && std::regex_match(value, std::regex("[0-9]{1,9}(\\.[0-9]{1,9})?")) && std::stod(value) > 1) {
+            options.kill = std::stod(value);
+        } else if (name == "pyramid" && !match[2].matched) {
+            options.pyramid = true;
+        } else if (name == "distance" && !match[2].matched) {
+            options.distance = true;
+        } else if (name == "huge-pages" && !match[2].matched) {
+            options.hugePages = true;
+        } else if (name == "first-touch" && (value == "main" || value == "parallel")) {
+            options.parallelTouch = value == "parallel";
+        } else if (name == "batch" && std::regex_match(value, std::regex("[0-9]{1,19}"))) {
+            options.batch = std::stoul(value);
+        } else if (name == "simd" && (value == "auto" || value == "scalar" || value == "avx2" || value == "avx512")) {
+            options.simd = value;
+        } else if (name == "benchmark" && !match[2].matched) {
+            options.benchmark = true;
+        } else if (name == "crop" && !match[2].matched) {
+            options.crop = true;
+        } else if (name == "check" && !match[2].matched) {
+            options.check = true;
+        } else if (name == "seed" && std::regex_match(value, std::regex("[0-9]{1,19}"))) {
+            options.seeded = true;
+            options.seed = std::stoull(value);
+        } else if (name == "rng" && (value == "philox" || value == "xoshiro")) {
+            options.rng = value;
+        } else if (name == "log-seeds" && !match[2].matched) {
+            options.logSeeds = true;
+        } else if (name == "producers" && !match[2].matched) {
+            options.producers = true;
+        } else if (name == "moves" && (value == "moore" || value == "neumann")) {
+            options.moves = value;
+        } else if (name == "drift" && std::regex_match(value, std::regex("-?[0-9]{1,9}(\\.[0-9]{1,9})?,-?[0-9]{1,9}(\\.[0-9]{1,9})?"))) {
+            options.driftX = std::stod(value.substr(0, value.find(',')));
+            options.driftY = std::stod(value.substr(value.find(',') + 1));
+        } else if (name == "weights" && std::regex_match(value, std::regex("[0-9]{1,9}(\\.[0-9]{1,9})?(,[0-9]{1,9}(\\.[0-9]{1,9})?){8}"))) {
+            options.weights.clear();
+            std::size_t start = 0;
+            for (int k = 0; k < 9; k++) {
+                const std::size_t end = value.find(',', start);
+                options.weights.push_back(std::stod(value.substr(start, end - start)));
+                start = end + 1;
+            }
+        } else {
+            std::cerr << "Invalid option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    /* the other walks, kill returns, batches and producers are built for
+       the uniform 9-move walk */
+    if (biasedWalk(options) && (options.walk != "step" || options.kill > 0 || options.batch > 0 || options.producers)) {
+        std::cerr << "--moves=neumann, --drift and --weights need --walk=step and no --kill, --batch or --producers" << std::endl;
+        return false;
+    }
+
+    /* batches only take single lattice steps and update no walk
+       structures of their own */
+    if (options.batch > 0 && (options.model != "lattice" || options.walk != "step" || options.pyramid || options.distance || options.producers)) {
+        std::cerr << "--batch needs --model=lattice, --walk=step and no --pyramid, --distance or --producers" << std::endl;
+        return false;
+    }
+
+    /* the kernel must have finite weights and move walkers somewhere,
+       or MoveKernel would divide by a zero or infinite total */
+    if (biasedWalk(options)) {
+        const std::vector<double> weights = kernelWeights(options.moves, options.weights, options.driftX, options.driftY);
+        double total = 0;
+        double moving = 0;
+        for (int k = 0; k < MOVES; k++) {
+            total += weights[k];
+            moving += k == MOVES / 2 ? 0 : weights[k];
+        }
+        if (!std::isfinite(total) || !(moving > 0)) {
+            std::cerr << "Invalid option: --moves, --drift and --weights must give finite weights and some move off the current cell" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**********************************************************************
+ * seed of the run: the --seed option, or the system clock
+ *
+ * note: printed with --log-seeds, so a run from the clock can be
+ * repeated with --seed
+***********************************************************************/
+inline std::uint64_t runSeed(const Options& options) {
+    const std::uint64_t seed = options.seeded ? options.seed : std::chrono::system_clock::now().time_since_epoch().count();
+    if (options.logSeeds) {
+        std::cout << "seed " << seed << " (" << options.rng << ")" << std::endl;
+    }
+    return seed;
+}
+
+#endif
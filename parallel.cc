@@ -3,116 +3,393 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <random>
 #include <regex>
 #include <tuple>
+#include <utility>
+#include <vector>
 
+#include "distance.h"
+#include "hops.h"
+#include "lattice.h"
+#include "launch.h"
+#include "offlattice.h"
+#include "options.h"
+#include "producer.h"
+#include "pyramid.h"
+#include "rng.h"
+#include "walk.h"
 #include "omp.h"
 
 
 /**********************************************************************
- * reads grid location, thread-safe
+ * zeroes lattice storage from all threads, so each thread's band of
+ * pages is first touched, and therefore placed, on its own NUMA node
 ***********************************************************************/
-char readGrid(std::vector<std::vector<char>>& grid, const int x, const int y) {
-    char value;
-    #pragma omp atomic read
-    value = grid[x][y];
-    return value;
+void parallelZero(char* bytes, const std::size_t count) {
+    const std::size_t page = allocationPolicy().hugePages ? AllocationPolicy::HUGE_PAGE : 4096;
+    const long pages = static_cast<long>((count + page - 1) / page);
+    #pragma omp parallel for schedule(static)
+    for (long p = 0; p < pages; p++) {
+        const std::size_t offset = p * page;
+        std::memset(bytes + offset, 0, std::min(page, count - offset));
+    }
 }
 
 /**********************************************************************
- * writes to grid location, thread-safe
+ * raises *target to value if value is larger, without a lock
+ *
+ * note: a compare-and-swap loop that stops as soon as *target is at
+ * least value, so an update that loses to a larger one costs one load;
+ * relaxed, since the radius only bounds where walkers launch and the
+ * cells it covers are read relaxed anyway
 ***********************************************************************/
-void writeGrid(std::vector<std::vector<char>>& grid, const int x, const int y, const char value) {
-    #pragma omp atomic write
-    grid[x][y] = value;
+void fetchMax(int* target, const int value) {
+    int current = __atomic_load_n(target, __ATOMIC_RELAXED);
+    while (value > current &&
+           !__atomic_compare_exchange_n(target, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**********************************************************************
+ * prints ns per particle of reading and raising a shared radius through
+ * a critical section and through a relaxed load and fetchMax, on 8, 32
+ * and 128 threads
+ *
+ * note: each particle reads the radius and raises it to the number of
+ * particles its thread has run, the pattern of the free-running loop
+ * with none of the walk in between, so this is the worst case for
+ * contention; threads beyond the hardware's are oversubscribed
+***********************************************************************/
+void benchmarkRadius(std::ostream& out) {
+    const long particles = 200000;
+    out << "radius updates on " << omp_get_num_procs() << " processors" << std::endl;
+    for (const int threads : {8, 32, 128}) {
+        int radius = 0;
+        long checksum = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        #pragma omp parallel num_threads(threads) reduction(+ : checksum)
+        for (long i = 0; i < particles; i++) {
+            int tempRadius;
+            #pragma omp critical (benchmark)
+            {
+                tempRadius = radius;
+            }
+            checksum += tempRadius;
+            #pragma omp critical (benchmark)
+            {
+                if (i > radius) {
+                    radius = static_cast<int>(i);
+                }
+            }
+        }
+        const double critical = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (particles * threads);
+
+        radius = 0;
+        start = std::chrono::high_resolution_clock::now();
+        #pragma omp parallel num_threads(threads) reduction(+ : checksum)
+        for (long i = 0; i < particles; i++) {
+            checksum += __atomic_load_n(&radius, __ATOMIC_RELAXED);
+            fetchMax(&radius, static_cast<int>(i));
+        }
+        const double atomic = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (particles * threads);
+        out << threads << " threads: critical " << critical << " ns/particle, atomic " << atomic
+            << " ns/particle (checksum " << checksum << ")" << std::endl;
+    }
 }
 
 /**********************************************************************
  * generates a random point outside of the radius of the crystal
 ***********************************************************************/
-std::tuple<int, int> generatePoint(std::default_random_engine& generator, std::vector<std::vector<char>>& grid, const int gridSize, const int center, const int radius) {
+template <typename G, typename L>
+std::tuple<int, int> generatePoint(G& generator, const L& grid, const int gridSize, const int center, const int radius) {
     std::uniform_int_distribution<int> distribution(0, gridSize - 1);
     int x, y;
     do {
         x = distribution(generator);
         y = distribution(generator);
-    } while ((abs(center - x) <= radius + 1 && abs(center - y) <= radius + 1) || readGrid(grid, x, y) != 0);
+    } while ((abs(center - x) <= radius + 1 && abs(center - y) <= radius + 1) || grid.occupied(x, y));
     return std::make_tuple(x, y);
 }
 
 /**********************************************************************
  * calculates the next random move for a particle
  * 
- * note: the next move could cause particle to leave the lattice
+ * note: the next move could cause particle to leave the lattice; moves
+ * are harvested many at a time from 64-bit engine outputs, or taken
+ * from a producer thread's ring
 ***********************************************************************/
-std::tuple<int, int> nextMove(std::default_random_engine& generator) {
-    std::uniform_int_distribution<int> distribution(-1, 1);
+template <typename M>
+std::tuple<int, int> nextMove(M& moves) {
     int dx, dy;
-    dx = distribution(generator);
-    dy = distribution(generator);
+    moves.next(dx, dy);
     return std::make_tuple(dx, dy);
 }
 
-/* determines if the current particle should stick to the crystal */
-bool shouldStick(std::vector<std::vector<char>>& grid, const int gridSize, const int x, const int y) {
-    for (int dx = -1; dx <= 1; dx++) {
-        for (int dy = -1; dy <= 1; dy++) {
-            const int newX = x + dx;
-            const int newY = y + dy;
-            if (newX >= 0 && newX < gridSize && newY >= 0 && newY < gridSize && readGrid(grid, newX, newY) == 'X') {
-                writeGrid(grid, x, y, 'X');
-                return true;
+/**********************************************************************
+ * determines if the current particle should stick to the crystal, sticks
+ * it if so
+ *
+ * note: a shared radius and the acceleration structures are updated
+ * before the cell is placed, so no other walker can find the cell while
+ * they still leave it out
+***********************************************************************/
+template <typename L>
+bool shouldStick(L& grid, const WalkSettings& walk, const int x, const int y) {
+    if (grid.touchesCrystal(x, y)) {
+        /* a walk with a footprint leaves placing to its caller */
+        if (walk.footprint == nullptr) {
+            if (walk.sharedRadius != nullptr) {
+                fetchMax(walk.sharedRadius, std::max(std::abs(walk.center - x), std::abs(walk.center - y)));
             }
+            recordStick(walk, x, y);
+            grid.place(x, y);
         }
+        return true;
     }
     return false;
 }
 
 /**********************************************************************
  * walks particle until it leaves lattice or sticks to the crystal
+ *
+ * note: draws from the generator exactly as sequential.cc does while no
+ * other thread changes the crystal
 ***********************************************************************/
-void walkParticle(std::default_random_engine& generator, std::vector<std::vector<char>>& grid, const int gridSize, int& x, int& y) {
-    while (x >= 0 && x < gridSize && y >= 0 && y < gridSize) {
-        /* check if should stick */
-        if (shouldStick(grid, gridSize, x, y)) {
-            return;
+template <typename G, typename M, typename L>
+void walkParticle(G& generator, M& moves, L& grid, const WalkSettings& walk, int& x, int& y) {
+
+    /* steps the particle can take before it could reach the crystal */
+    int safeSteps = 0;
+    while (grid.contains(x, y)) {
+        if (walk.footprint != nullptr) {
+            walk.footprint->cover(x, y, 1);
+        }
+        bool moved = false;
+        if (safeSteps > 0) {
+            safeSteps--;
+        } else {
+            /* check if should stick */
+            if (shouldStick(grid, walk, x, y)) {
+                return;
+            }
+
+            /* cross empty space in one move when far enough from the crystal */
+            int newX = x;
+            int newY = y;
+            bool crossed = false;
+            if (walk.mode == WalkMode::JUMP) {
+                const double reach = jumpRadius(walk, grid.size(), x, y);
+                if (reach >= MIN_JUMP) {
+                    jumpOnCircle(generator, reach, newX, newY);
+                    crossed = true;
+                }
+            } else if (walk.mode == WalkMode::HOP) {
+                const int level = DisplacementTables::levelFor(squareClearance(walk, grid.size(), x, y));
+                if (level > 0) {
+                    walk.hops->hop(generator, level, newX, newY);
+                    crossed = true;
+                }
+            } else if (walk.mode == WalkMode::SQUARE) {
+                const int index = walk.exits->indexFor(squareClearance(walk, grid.size(), x, y));
+                if (index >= 0) {
+                    walk.exits->exit(generator, index, newX, newY);
+                    crossed = true;
+                }
+            }
+
+            /* another thread may have filled the landing cell meanwhile; a
+               hop may also land where it started, which still counts */
+            if (crossed && !grid.occupied(newX, newY)) {
+                x = newX;
+                y = newY;
+                moved = true;
+            }
+
+            /* within r steps of an empty square of radius r nothing is
+               reachable; the steps it skips decide when the next crossing
+               is tried, so a walk that crosses covers where r came from
+               (single steps cover each cell they test anyway) */
+            if (!moved && walk.pyramid != nullptr) {
+                const int empty = walk.pyramid->emptyRadius(x, y);
+                if (walk.mode != WalkMode::STEP) {
+                    coverEmptyRadius(walk, x, y, empty);
+                }
+                safeSteps = empty - 1;
+            }
         }
 
-        int newX;
-        int newY;
-        do {
-        const std::tuple<int, int> direction = nextMove(generator);
-        const int dx = std::get<0>(direction);
-        const int dy = std::get<1>(direction);
-        newX = x + dx;
-        newY = y + dy;
-        } while (newX >= 0 && newX < gridSize && newY >= 0 && newY < gridSize && readGrid(grid, newX, newY) != 0);
+        if (!moved) {
+            int newX;
+            int newY;
+            do {
+            const std::tuple<int, int> direction = nextMove(moves);
+            const int dx = std::get<0>(direction);
+            const int dy = std::get<1>(direction);
+            newX = x + dx;
+            newY = y + dy;
+            } while (grid.contains(newX, newY) && grid.occupied(newX, newY));
+
+            x = newX;
+            y = newY;
+        }
 
-        x = newX;
-        y = newY;
+        /* return strays to the launch circle */
+        if (walk.kill != nullptr && walk.kill->outside(x, y)) {
+            walk.kill->returnWalker(generator, x, y);
+            safeSteps = 0;
+        }
+    }
+}
+
+/**********************************************************************
+ * launches a particle around a crystal of radius walk.radius and walks
+ * it until it leaves the lattice or sticks, leaving (x, y) where it
+ * stopped
+ *
+ * note: lattice steps come from walk.kernel or else ring if either is
+ * not nullptr, otherwise they are harvested from generator like every
+ * other draw
+***********************************************************************/
+template <typename G, typename L>
+void runParticle(const Options& options, L& grid, const WalkSettings& walk, G& generator, RingMoves* ring, int& x, int& y) {
+    /* generate point, on the launch circle if requested and it fits */
+    const double launch = launchRadius(walk.radius);
+    const auto point = options.inject == "circle" && circleFits(walk.center, launch)
+        ? pointOnCircle(generator, walk.center, launch)
+        : generatePoint(generator, grid, grid.size(), walk.center, walk.radius);
+    x = std::get<0>(point);
+    y = std::get<1>(point);
+
+    /* kill circle, if requested and it fits */
+    const KillCircle kill = {walk.center, launch, options.kill * launch};
+    const bool killing = options.kill > 1 && circleFits(walk.center, kill.killRadius);
+
+    /* walk particle until it leaves lattice or sticks to the crystal */
+    WalkSettings settings = walk;
+    settings.kill = killing ? &kill : nullptr;
+    if (walk.kernel != nullptr) {
+        KernelMoves<G> moves(*walk.kernel, generator);
+        walkParticle(generator, moves, grid, settings, x, y);
+    } else if (ring != nullptr) {
+        walkParticle(generator, *ring, grid, settings, x, y);
+    } else {
+        MoveHarvester<G> moves(generator);
+        walkParticle(generator, moves, grid, settings, x, y);
+    }
+}
+
+/**********************************************************************
+ * xoshiro256** engine of the calling thread for --rng=xoshiro, jumped
+ * once per lower thread number so no two threads' streams overlap
+ *
+ * note: built once per thread at the start of a parallel region
+***********************************************************************/
+Xoshiro256 threadEngine(const Options& options, const std::uint64_t seed) {
+    Xoshiro256 engine(seed);
+    const int thread = omp_get_thread_num();
+    for (int t = 0; t < thread; t++) {
+        engine.jump();
+    }
+    if (options.logSeeds && options.rng == "xoshiro") {
+        #pragma omp critical (log)
+        std::cout << "thread " << thread << ": seed " << seed << " jumped " << thread << " times" << std::endl;
+    }
+    return engine;
+}
+
+/* particles per thread walked ahead in each round of a seeded run */
+const unsigned long REPLAY_ROUND = 16;
+
+/**********************************************************************
+ * grows the crystal from numParticles particles exactly as the
+ * sequential loop does from the same seed, whatever the thread count
+ *
+ * note: each round walks its particles in parallel against the crystal
+ * as it stood when the round began, placing nothing and recording each
+ * walk's footprint. The particles are then committed in index order. A
+ * particle with a cell committed earlier in the round in its footprint
+ * is walked again from the start of its stream against the grown
+ * crystal, since only then could its course differ; once the radius
+ * grows every later launch moves, so the round ends there and the next
+ * one starts from that particle. Replays run on one thread, so the
+ * speedup is bounded by the share of particles that need one.
+***********************************************************************/
+template <typename L>
+void growReproducibly(const Options& options, L& grid, const WalkSettings& structures, const std::uint64_t seed, int& radius, const unsigned long numParticles) {
+    const int limit = grid.size() / 2 - 1;
+    const unsigned long round = REPLAY_ROUND * omp_get_max_threads();
+    std::vector<Footprint> footprints(round);
+    std::vector<int> xs(round);
+    std::vector<int> ys(round);
+    std::vector<std::pair<int, int>> committed;
+    unsigned long first = 0;
+    while (first < numParticles && radius < limit) {
+        const unsigned long last = std::min(numParticles, first + round);
+        reserveRadius(grid, radius + static_cast<int>(last - first));
+
+        /* walk the round ahead against a fixed crystal */
+        const int start = radius;
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (unsigned long i = first; i < last; i++) {
+            WalkSettings walk = structures;
+            walk.radius = start;
+            walk.footprint = &footprints[i - first];
+            walk.footprint->clear();
+            Philox generator(seed, i);
+            runParticle(options, grid, walk, generator, nullptr, xs[i - first], ys[i - first]);
+        }
+
+        /* commit in index order, replaying walks the round invalidated */
+        committed.clear();
+        unsigned long i = first;
+        for (; i < last && radius == start; i++) {
+            const unsigned long k = i - first;
+            bool stale = false;
+            for (std::size_t c = 0; !stale && c < committed.size(); c++) {
+                stale = footprints[k].covers(committed[c].first, committed[c].second);
+            }
+            if (stale) {
+                WalkSettings walk = structures;
+                walk.radius = radius;
+                walk.footprint = &footprints[k];
+                Philox generator(seed, i);
+                runParticle(options, grid, walk, generator, nullptr, xs[k], ys[k]);
+            }
+
+            /* place a stuck particle and update radius if necessary */
+            if (grid.contains(xs[k], ys[k])) {
+                grid.place(xs[k], ys[k]);
+                recordStick(structures, xs[k], ys[k]);
+                committed.push_back(std::make_pair(xs[k], ys[k]));
+                radius = std::max(radius, std::max(std::abs(structures.center - xs[k]), std::abs(structures.center - ys[k])));
+            }
+        }
+        first = i;
     }
 }
 
 /**********************************************************************
  * write result to file
+ *
+ * note: only rows and columns in [low, high) are written; cells hold 1
+ * for the crystal, or the attachment index with --lattice=order
 ***********************************************************************/
-void writeToFile(const std::vector<std::vector<char>>& grid, const int gridSize) {
+template <typename L>
+void writeToFile(const L& grid, const int low, const int high) {
     std::ofstream myfile;
     myfile.open("parallel_result.txt");
-    for (int i = 0; i < gridSize; i++) {
-        for (int k = 0; k < gridSize; k++) {
-            int value = 0;
-            if (grid[i][k] != 0) {
-                value = 1;
-            }
-            if (k != 0) {
+    for (int i = low; i < high; i++) {
+        for (int k = low; k < high; k++) {
+            const std::uint32_t value = cellValue(grid, i, k);
+            if (k != low) {
                 myfile << ",";
             }
             myfile << value;
         }
-        if (i != gridSize - 1) {
+        if (i != high - 1) {
             myfile << "\n";
         }
     }
@@ -122,13 +399,14 @@ void writeToFile(const std::vector<std::vector<char>>& grid, const int gridSize)
 /**********************************************************************
  * print crude result visual to console
 ***********************************************************************/
-void consoleVisual(const std::vector<std::vector<char>>& grid, const int gridSize) {
+template <typename L>
+void consoleVisual(const L& grid, const int gridSize) {
     /* print crude depiction of final crystal inside lattice */
     for (int i = 0; i < gridSize; i++) {
         for (int k = 0; k < gridSize; k++) {
-            char value = grid[i][k];
-            if (value == 0) {
-                value = '-';
+            char value = '-';
+            if (grid.occupied(i, k)) {
+                value = 'X';
             }
             std::cout << value << " ";
         }
@@ -137,12 +415,236 @@ void consoleVisual(const std::vector<std::vector<char>>& grid, const int gridSiz
 }
 
 /**********************************************************************
- * main function to manage crystal, lattice, and particles sequentially
+ * manages crystal, lattice, and particles in parallel on lattice type L
+***********************************************************************/
+template <typename L>
+void simulate(const Options& options, const int gridSize, const unsigned long numParticles) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    L grid(gridSize);
+
+    /* initialize radius and center */
+    int radius = 0;
+    const int center = gridSize / 2;
+
+    /* create occupancy pyramid if requested */
+    std::unique_ptr<OccupancyPyramid> pyramid;
+    if (options.pyramid) {
+        pyramid.reset(new OccupancyPyramid(gridSize));
+    }
+
+    /* create distance field if requested */
+    std::unique_ptr<DistanceField> distance;
+    if (options.distance) {
+        distance.reset(new DistanceField(gridSize));
+    }
+
+    /* build multi-step displacement tables if requested */
+    std::unique_ptr<DisplacementTables> hops;
+    if (options.walk == "hop") {
+        hops.reset(new DisplacementTables());
+    }
+
+    /* build exit distributions of empty squares if requested */
+    std::unique_ptr<ExitTables> exits;
+    if (options.walk == "square") {
+        exits.reset(new ExitTables());
+    }
+
+    /* build the move kernel of a biased walk if requested */
+    std::unique_ptr<MoveKernel> kernel;
+    if (biasedWalk(options)) {
+        kernel.reset(new MoveKernel(kernelWeights(options.moves, options.weights, options.driftX, options.driftY)));
+    }
+
+    /* place starting crystal */
+    grid.place(center, center);
+    if (pyramid) {
+        pyramid->mark(center, center);
+    }
+    if (distance) {
+        distance->update(center, center);
+    }
+
+    /* seed from the options or the system clock */
+    const std::uint64_t seed = runSeed(options);
+    const bool xoshiro = options.rng == "xoshiro";
+    const WalkSettings structures = {center, radius, nullptr, pyramid.get(), distance.get(), hops.get(), exits.get(), nullptr, walkMode(options.walk), kernel.get(), nullptr};
+
+    /* a seeded run must not depend on how threads interleave, which
+       takes a stream per particle */
+    const bool reproducible = options.seeded && !xoshiro;
+    if (reproducible) {
+        growReproducibly(options, grid, structures, seed, radius, numParticles);
+    }
+
+    /* a lattice that grows lazily is reserved in rounds; each stuck
+       particle extends the radius by at most one, so a round as long as
+       the radius (at least MIN_ROUND) keeps the window within a few
+       times the crystal. Other lattices run every particle in one round */
+    const bool rounds = growsLazily(grid);
+    const unsigned long MIN_ROUND = 64;
+    unsigned long first = 0;
+    unsigned long last = reproducible ? numParticles : 0;
+    #pragma omp parallel if (!reproducible)
+    {
+        Xoshiro256 engine = threadEngine(options, seed);
+
+        /* this thread's move producer, jumped past every thread engine */
+        std::unique_ptr<MoveProducer> producer;
+        std::unique_ptr<RingMoves> ring;
+        if (options.producers && !reproducible) {
+            producer.reset(new MoveProducer(seed, omp_get_num_threads() + omp_get_thread_num()));
+            ring.reset(new RingMoves(producer->ring()));
+        }
+
+        while (true) {
+            /* first and last only change here, between the barriers */
+            #pragma omp single
+            {
+                first = last;
+                const int reach = __atomic_load_n(&radius, __ATOMIC_RELAXED);
+                last = numParticles;
+                if (rounds) {
+                    last = std::min(numParticles, first + std::max<unsigned long>(reach, MIN_ROUND));
+                    reserveRadius(grid, reach + static_cast<int>(last - first));
+                }
+            }
+            if (first >= numParticles) {
+                break;
+            }
+
+            #pragma omp for schedule(dynamic, 1)
+            for (unsigned long i = first; i < last; i++) {
+                /* check if radius is the entire grid */
+                const int tempRadius = __atomic_load_n(&radius, __ATOMIC_RELAXED);
+                if (tempRadius >= gridSize / 2 - 1) {
+                    continue;
+                }
+
+                /* walk particle i on its thread's engine or its own stream;
+                   it raises the shared radius itself if it sticks */
+                WalkSettings walk = structures;
+                walk.radius = tempRadius;
+                walk.sharedRadius = &radius;
+                int x, y;
+                if (xoshiro) {
+                    runParticle(options, grid, walk, engine, ring.get(), x, y);
+                } else {
+                    Philox generator(seed, i);
+                    runParticle(options, grid, walk, generator, ring.get(), x, y);
+                }
+            }
+        }
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() / 1000.0 << " s" << std::endl;
+
+    if (options.crop) {
+        const int margin = std::min(radius + 1, center);
+        writeToFile(grid, center - margin, center + margin + 1);
+    } else {
+        writeToFile(grid, 0, gridSize);
+    }
+}
+
+/**********************************************************************
+ * grows an off-lattice cluster of unit-diameter disks in parallel, then
+ * writes it rasterized onto lattice type L
+ *
+ * note: disks start on the launch circle around the cluster's bounding
+ * circle; the rasterized cell of each disk is its rounded center, in
+ * attachment order
+***********************************************************************/
+template <typename L>
+void simulateOffLattice(const Options& options, const int gridSize, const unsigned long numParticles) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    /* the launch circle must fit, so the cluster stays inside a disk of
+       diameter gridSize and never holds more than gridSize^2 disks */
+    const int center = gridSize / 2;
+    DiskCluster cluster(gridSize, std::min(static_cast<std::size_t>(numParticles) + 1, static_cast<std::size_t>(gridSize) * gridSize));
+    cluster.add(center, center);
+
+    /* seed from the options or the system clock; disks stick in whatever
+       order threads reach the cluster, so only a single thread reproduces
+       a seeded run */
+    const std::uint64_t seed = runSeed(options);
+
+    /* run every disk in parallel; the cluster raises its radius before it
+       publishes each stuck disk, so a walker's bound covers every disk it
+       could have found, and a disk that sticks while a walker jumps is
+       one that stuck just after the jump */
+    #pragma omp parallel
+    {
+        Xoshiro256 engine = threadEngine(options, seed);
+        #pragma omp for schedule(dynamic, 1)
+        for (unsigned long i = 0; i < numParticles; i++) {
+            /* check if the launch circle still fits in the domain */
+            const double launch = cluster.radius() + LAUNCH_GAP;
+            if (!circleFits(center, launch)) {
+                continue;
+            }
+
+            /* walk disk until it leaves the domain or touches the cluster */
+            if (options.rng == "xoshiro") {
+                runDisk(engine, cluster, center, launch, options.kill);
+            } else {
+                Philox generator(seed, i);
+                runDisk(generator, cluster, center, launch, options.kill);
+            }
+        }
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() / 1000.0 << " s" << std::endl;
+
+    /* rasterize the disks in attachment order */
+    const int radius = static_cast<int>(std::ceil(cluster.radius()));
+    L grid(gridSize);
+    reserveRadius(grid, radius + 1);
+    for (std::size_t i = 0; i < cluster.count(); i++) {
+        const int x = static_cast<int>(std::lround(cluster.x(i)));
+        const int y = static_cast<int>(std::lround(cluster.y(i)));
+        if (grid.contains(x, y) && !grid.occupied(x, y)) {
+            grid.place(x, y);
+        }
+    }
+
+    if (options.crop) {
+        const int margin = std::min(radius + 1, center);
+        writeToFile(grid, center - margin, center + margin + 1);
+    } else {
+        writeToFile(grid, 0, gridSize);
+    }
+}
+
+/**********************************************************************
+ * runs the simulation on lattice type L, with or without the sticky mask
+ *
+ * note: the off-lattice model only uses L to write its result
+***********************************************************************/
+template <typename L>
+void simulateWith(const Options& options, const int gridSize, const unsigned long numParticles) {
+    if (options.model == "offlattice") {
+        simulateOffLattice<L>(options, gridSize, numParticles);
+    } else if (options.sticky) {
+        simulate<StickyLattice<L>>(options, gridSize, numParticles);
+    } else {
+        simulate<L>(options, gridSize, numParticles);
+    }
+}
+
+/**********************************************************************
+ * main function to parse arguments and select the lattice type
 ***********************************************************************/
 int main(int argc, char* argv[]) {
     /* check for proper arguments */
-    if (argc != 3) {
-        std::cerr << "Requires one argument\n\nUsage:\n\t./sequential <grid_size> <num_particles>" << std::endl;
+    if (argc < 3) {
+        std::cerr << "Requires two arguments\n\nUsage:\n\t./parallel <grid_size> <num_particles> [options]\n\nOptions:\n" << OPTIONS_USAGE << std::endl;
         exit(EXIT_FAILURE);
     }
 
@@ -172,63 +674,47 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    auto start_time = std::chrono::high_resolution_clock::now();
-
     const int gridSize = tempSize;
     const unsigned long numParticles = tempParticles;
 
-    std::vector<std::vector<char>> grid(gridSize, std::vector<char>(gridSize));
-
-    /* initialize radius and center */
-    int radius = 0;
-    const int center = gridSize / 2;
-
-    /* place starting crystal */
-    grid[center][center] = 'X';
-
-    #pragma omp parallel for schedule(dynamic, 1)
-    for (unsigned long i = 0; i < numParticles; i++) {
-
-        /* create random number generator */
-        std::default_random_engine generator;
-    
-        /* seed generator with system clock */
-        unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-        generator.seed(seed);
-
-        /* check if radius is the entire grid */
-        int tempRadius;
-        #pragma omp critical (radius)
-        {
-            tempRadius = radius;
-        }
-        if (tempRadius >= gridSize / 2 - 1) {
-            continue;
-        }
-
-        /* generate point */
-        const auto point = generatePoint(generator, grid, gridSize, center, tempRadius);
-        int x = std::get<0>(point);
-        int y = std::get<1>(point);
-
-        /* walk particle until it leaves lattice or sticks to the crystal */
-        walkParticle(generator, grid, gridSize, x, y);
+    /* parse optional arguments */
+    Options options;
+    if (!parseOptions(argc, argv, 3, true, options)) {
+        exit(EXIT_FAILURE);
+    }
+    allocationPolicy().hugePages = options.hugePages;
+    if (options.parallelTouch) {
+        allocationPolicy().zero = parallelZero;
+    }
 
-        /* check if particle stuck, if it did update radius if necessary */
-        if (x >= 0 && x < gridSize && y >= 0 && y < gridSize) {
-            const int distance = std::max(std::abs(center - x), std::abs(center - y));
-            #pragma omp critical (radius)
-            {
-                if (distance > radius) {
-                    radius = distance;
-                }
-            }
+    /* check the walk tables against simulated single steps if requested */
+    if (options.check) {
+        Philox generator(std::chrono::system_clock::now().time_since_epoch().count(), 0);
+        checkMoves(generator, 9000000, std::cout);
+        DisplacementTables().check(generator, 100000, std::cout);
+        if (biasedWalk(options)) {
+            checkKernel(MoveKernel(kernelWeights(options.moves, options.weights, options.driftX, options.driftY)), generator, 9000000, std::cout);
         }
     }
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-
-    std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() / 1000.0 << " s" << std::endl;
+    /* time shared radius updates if requested */
+    if (options.benchmark) {
+        benchmarkRadius(std::cout);
+    }
 
-    writeToFile(grid, gridSize);
+    if (options.lattice == "bits") {
+        simulateWith<BitLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "padded") {
+        simulateWith<PaddedLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "morton") {
+        simulateWith<MortonLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "sparse") {
+        simulateWith<SparseLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "order") {
+        simulateWith<OrderLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "growing") {
+        simulateWith<GrowingLattice>(options, gridSize, numParticles);
+    } else {
+        simulateWith<Lattice>(options, gridSize, numParticles);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+#ifndef PRODUCER_H
+#define PRODUCER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+#include "rng.h"
+
+/* moves packed into each ring word, 4 bits apiece */
+const int MOVES_PER_WORD = 16;
+
+/**********************************************************************
+ * lock-free single-producer single-consumer ring of 64-bit words, each
+ * holding MOVES_PER_WORD moves of the 9-move walk (0 .. 8) in 4-bit
+ * fields, lowest first
+ *
+ * note: head_ counts words pushed and tail_ words popped; each side
+ * stores its own counter with release and loads the other's with
+ * acquire, and keeps a cached copy of the other's so it only touches
+ * the shared line when the ring looks full or empty
+***********************************************************************/
+class MoveRing {
+public:
+    static constexpr std::size_t WORDS = 4096;
+
+    /* producer side; false if the ring is full */
+    bool push(const std::uint64_t word) {
+        if (head_ - tailCache_ == WORDS) {
+            tailCache_ = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+            if (head_ - tailCache_ == WORDS) {
+                return false;
+            }
+        }
+        words_[head_ % WORDS] = word;
+        __atomic_store_n(&head_, head_ + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /* consumer side; false if the ring is empty */
+    bool pop(std::uint64_t& word) {
+        if (tail_ == headCache_) {
+            headCache_ = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+            if (tail_ == headCache_) {
+                return false;
+            }
+        }
+        word = words_[tail_ % WORDS];
+        __atomic_store_n(&tail_, tail_ + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    alignas(64) std::size_t head_ = 0;
+    std::size_t tailCache_ = 0;
+    alignas(64) std::size_t tail_ = 0;
+    std::size_t headCache_ = 0;
+    alignas(64) std::uint64_t words_[WORDS];
+};
+
+/**********************************************************************
+ * thread that keeps a MoveRing full of moves harvested from its own
+ * xoshiro256** engine, seeded from seed and jumped jumps times
+ *
+ * note: the thread yields while the ring is full and stops when the
+ * producer is destroyed
+***********************************************************************/
+class MoveProducer {
+public:
+    MoveProducer(const std::uint64_t seed, const int jumps) : engine_(seed) {
+        for (int j = 0; j < jumps; j++) {
+            engine_.jump();
+        }
+        thread_ = std::thread([this] {
+            run();
+        });
+    }
+
+    ~MoveProducer() {
+        __atomic_store_n(&stop_, true, __ATOMIC_RELAXED);
+        thread_.join();
+    }
+
+    MoveProducer(const MoveProducer&) = delete;
+    MoveProducer& operator=(const MoveProducer&) = delete;
+
+    MoveRing& ring() {
+        return ring_;
+    }
+
+private:
+    void run() {
+        MoveHarvester<Xoshiro256> moves(engine_);
+        while (!__atomic_load_n(&stop_, __ATOMIC_RELAXED)) {
+            std::uint64_t word = 0;
+            for (int k = 0; k < MOVES_PER_WORD; k++) {
+                word |= static_cast<std::uint64_t>(moves.next()) << (4 * k);
+            }
+            while (!ring_.push(word) && !__atomic_load_n(&stop_, __ATOMIC_RELAXED)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    Xoshiro256 engine_;
+    MoveRing ring_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+/**********************************************************************
+ * moves of the 9-move walk taken from a MoveProducer's ring, with the
+ * interface of MoveHarvester
+ *
+ * note: waits, yielding, while the ring is empty
+***********************************************************************/
+class RingMoves {
+public:
+    explicit RingMoves(MoveRing& ring) : ring_(ring) {}
+
+    /* next move, 0 .. 8 */
+    int next() {
+        if (left_ == 0) {
+            while (!ring_.pop(word_)) {
+                std::this_thread::yield();
+            }
+            left_ = MOVES_PER_WORD;
+        }
+        const int move = static_cast<int>(word_ & 15);
+        word_ >>= 4;
+        left_--;
+        return move;
+    }
+
+    void next(int& dx, int& dy) {
+        const int move = next();
+        dx = move / 3 - 1;
+        dy = move % 3 - 1;
+    }
+
+private:
+    MoveRing& ring_;
+    std::uint64_t word_ = 0;
+    int left_ = 0;
+};
+
+/* ns per move of draws from moves, each followed by work dependent multiply-adds */
+template <typename M>
+double timeMoves(M& moves, const long draws, const int work, std::uint64_t& checksum) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (long i = 0; i < draws; i++) {
+        checksum += moves.next();
+        for (int k = 0; k < work; k++) {
+            checksum = checksum * 6364136223846793005u + 1442695040888963407u;
+        }
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / draws;
+}
+
+/**********************************************************************
+ * prints ns per move drawn inline from Philox and xoshiro256** and from
+ * a MoveProducer's ring, each draw followed by 0, 8 and 32 dependent
+ * multiply-adds standing in for the rest of a walk step
+ *
+ * note: the ring only wins when its producer has a hardware thread to
+ * itself and inline drawing costs more than popping a word every 16
+ * moves; the checksum keeps the work from being optimized away
+***********************************************************************/
+inline void benchmarkMoves(std::ostream& out) {
+    const long draws = 50000000;
+    std::uint64_t checksum = 0;
+    out << "move sources on " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    for (const int work : {0, 8, 32}) {
+        Philox philox(1, 0);
+        MoveHarvester<Philox> philoxMoves(philox);
+        Xoshiro256 xoshiro(1);
+        MoveHarvester<Xoshiro256> xoshiroMoves(xoshiro);
+        const double inlinePhilox = timeMoves(philoxMoves, draws, work, checksum);
+        const double inlineXoshiro = timeMoves(xoshiroMoves, draws, work, checksum);
+
+        /* the producer only runs while the ring is timed */
+        MoveProducer producer(1, 1);
+        RingMoves ringMoves(producer.ring());
+        const double ring = timeMoves(ringMoves, draws, work, checksum);
+        out << "work " << work << ": philox " << inlinePhilox << " ns/move, xoshiro " << inlineXoshiro
+            << " ns/move, ring " << ring << " ns/move" << std::endl;
+    }
+    out << "move checksum " << checksum << std::endl;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "lattice.h"
+
+/**********************************************************************
+ * multi-level occupancy summary of the crystal
+ *
+ * note: level k holds one bit per aligned 2^k x 2^k block of the
+ * lattice, set once any cell of the block has joined the crystal, up
+ * to a single block covering the whole domain. Marks are relaxed
+ * atomic fetch-ors applied from the coarsest level down, so a
+ * concurrent reader may see a block as occupied early but never as
+ * empty after its cell has been marked.
+***********************************************************************/
+class OccupancyPyramid {
+public:
+    explicit OccupancyPyramid(const int size) : size_(size) {
+        for (int level = 0; level == 0 || sideAt(level - 1) > 1; level++) {
+            const std::size_t side = sideAt(level);
+            const std::size_t stride = (side + 63) / 64;
+            strides_.push_back(stride);
+            levels_.push_back(static_cast<std::uint64_t*>(allocateCells(stride * side * sizeof(std::uint64_t))));
+        }
+    }
+
+    ~OccupancyPyramid() {
+        for (std::uint64_t* level : levels_) {
+            std::free(level);
+        }
+    }
+
+    OccupancyPyramid(const OccupancyPyramid&) = delete;
+    OccupancyPyramid& operator=(const OccupancyPyramid&) = delete;
+
+    int levels() const {
+        return static_cast<int>(levels_.size());
+    }
+
+    /* records that cell (x, y) joined the crystal */
+    void mark(const int x, const int y) {
+        for (int level = levels() - 1; level >= 0; level--) {
+            const std::size_t bit = static_cast<std::size_t>(y >> level);
+            std::uint64_t* word = &levels_[level][static_cast<std::size_t>(x >> level) * strides_[level] + bit / 64];
+            __atomic_fetch_or(word, std::uint64_t(1) << (bit % 64), __ATOMIC_RELAXED);
+        }
+    }
+
+    /* whether block (bx, by) of level is empty; blocks off the lattice are */
+    bool emptyBlock(const int level, const int bx, const int by) const {
+        const int side = static_cast<int>(sideAt(level));
+        if (bx < 0 || bx >= side || by < 0 || by >= side) {
+            return true;
+        }
+        const std::size_t bit = static_cast<std::size_t>(by);
+        const std::uint64_t word = __atomic_load_n(&levels_[level][static_cast<std::size_t>(bx) * strides_[level] + bit / 64], __ATOMIC_RELAXED);
+        return ((word >> (bit % 64)) & 1) == 0;
+    }
+
+    /**********************************************************************
+     * largest level whose aligned block containing (x, y) is empty
+     *
+     * note: returns -1 if (x, y) itself belongs to the crystal; the
+     * block at the returned level k spans 2^k cells per side
+    ***********************************************************************/
+    int emptyLevel(const int x, const int y) const {
+        int level = 0;
+        while (level < levels() && emptyBlock(level, x >> level, y >> level)) {
+            level++;
+        }
+        return level - 1;
+    }
+
+    /**********************************************************************
+     * largest r >= 1 such that every cell within max-norm distance r of
+     * (x, y) is known to be empty, 0 if not even the 3x3 neighborhood is
+     *
+     * note: at each level the 3x3 blocks around the block containing
+     * (x, y) are tested; if they are all empty the square they cover
+     * extends at least one block past (x, y) in every direction
+    ***********************************************************************/
+    int emptyRadius(const int x, const int y) const {
+        int radius = 0;
+        for (int level = 0; level < levels(); level++) {
+            const int bx = x >> level;
+            const int by = y >> level;
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    if (!emptyBlock(level, bx + dx, by + dy)) {
+                        return radius;
+                    }
+                }
+            }
+            const int block = 1 << level;
+            const int low = (bx - 1) * block;
+            const int high = (bx + 2) * block - 1;
+            const int left = (by - 1) * block;
+            const int right = (by + 2) * block - 1;
+            radius = std::min(std::min(x - low, high - x), std::min(y - left, right - y));
+        }
+        return radius;
+    }
+
+private:
+    std::size_t sideAt(const int level) const {
+        return (static_cast<std::size_t>(size_) + (std::size_t(1) << level) - 1) >> level;
+    }
+
+    const int size_;
+    std::vector<std::size_t> strides_;
+    std::vector<std::uint64_t*> levels_;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+/**********************************************************************
+ * xoshiro256** 64-bit engine (Blackman and Vigna)
+ *
+ * note: four words of state, a few shifts, rotates and adds per output
+ * and no division, against a 64-bit modulo per 31-bit output for
+ * minstd; seeded through splitmix64 so nearby seeds give unrelated
+ * states. jump() advances by 2^128 outputs, so engines jumped 0, 1, 2,
+ * ... times from one seed give non-overlapping streams.
+***********************************************************************/
+class Xoshiro256 {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256(const std::uint64_t seed = 0) {
+        this->seed(seed);
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~std::uint64_t(0);
+    }
+
+    void seed(std::uint64_t seed) {
+        for (std::uint64_t& word : state_) {
+            seed += 0x9e3779b97f4a7c15;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    result_type operator()() {
+        const std::uint64_t result = rotate(state_[1] * 5, 7) * 9;
+        const std::uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotate(state_[3], 45);
+        return result;
+    }
+
+    /* advances the engine by 2^128 outputs */
+    void jump() {
+        static const std::uint64_t JUMP[4] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+        std::uint64_t jumped[4] = {0, 0, 0, 0};
+        for (const std::uint64_t word : JUMP) {
+            for (int bit = 0; bit < 64; bit++) {
+                if (word & std::uint64_t(1) << bit) {
+                    for (int k = 0; k < 4; k++) {
+                        jumped[k] ^= state_[k];
+                    }
+                }
+                (*this)();
+            }
+        }
+        for (int k = 0; k < 4; k++) {
+            state_[k] = jumped[k];
+        }
+    }
+
+private:
+    static std::uint64_t rotate(const std::uint64_t x, const int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t state_[4];
+};
+
+/**********************************************************************
+ * Philox4x32-10 counter-based engine (Salmon et al., Random123)
+ *
+ * note: output block n of stream s under key k is a fixed bijection of
+ * the counter (n, s) keyed by k, so a particle's stream is a pure
+ * function of the run seed and its index and needs no state shared
+ * between threads; each block gives two 64-bit outputs
+***********************************************************************/
+class Philox {
+public:
+    using result_type = std::uint64_t;
+
+    Philox(const std::uint64_t seed, const std::uint64_t stream)
+        : key_{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+          stream_(stream) {}
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~std::uint64_t(0);
+    }
+
+    result_type operator()() {
+        if (used_ == 2) {
+            const std::uint32_t counter[4] = {
+                static_cast<std::uint32_t>(block_), static_cast<std::uint32_t>(block_ >> 32),
+                static_cast<std::uint32_t>(stream_), static_cast<std::uint32_t>(stream_ >> 32)};
+            std::uint32_t output[4];
+            Philox::block(counter, key_, output);
+            outputs_[0] = output[0] | static_cast<std::uint64_t>(output[1]) << 32;
+            outputs_[1] = output[2] | static_cast<std::uint64_t>(output[3]) << 32;
+            block_++;
+            used_ = 0;
+        }
+        return outputs_[used_++];
+    }
+
+    /* the ten rounds of Philox4x32 applied to one counter */
+    static void block(const std::uint32_t counter[4], const std::uint32_t key[2], std::uint32_t output[4]) {
+        std::uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        std::uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; round++) {
+            const std::uint64_t product0 = static_cast<std::uint64_t>(0xD2511F53) * c0;
+            const std::uint64_t product1 = static_cast<std::uint64_t>(0xCD9E8D57) * c2;
+            c0 = static_cast<std::uint32_t>(product1 >> 32) ^ c1 ^ k0;
+            c1 = static_cast<std::uint32_t>(product1);
+            c2 = static_cast<std::uint32_t>(product0 >> 32) ^ c3 ^ k1;
+            c3 = static_cast<std::uint32_t>(product0);
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        output[0] = c0;
+        output[1] = c1;
+        output[2] = c2;
+        output[3] = c3;
+    }
+
+private:
+    const std::uint32_t key_[2];
+    const std::uint64_t stream_;
+    std::uint64_t block_ = 0;
+    std::uint64_t outputs_[2] = {0, 0};
+    int used_ = 2;
+};
+
+/* 9^10, the number of 10-digit base-9 strings; fits in 32 bits */
+const std::uint32_t NINE_TO_THE_TEN = 3486784401u;
+
+/**********************************************************************
+ * moves of the 9-move walk harvested from 64-bit words of an engine
+ *
+ * note: each word is split into two 32-bit halves; a half below 9^10
+ * is a uniform 10-digit base-9 number and yields 10 moves, a half at or
+ * above it (19%) is dropped, so about 16 moves come from every word.
+ * Move k is dx = k / 3 - 1, dy = k % 3 - 1, uniform over the 9 moves.
+***********************************************************************/
+template <typename G>
+class MoveHarvester {
+public:
+    explicit MoveHarvester(G& engine) : engine_(engine) {}
+
+    /* next move, 0 .. 8 */
+    int next() {
+        if (left_ == 0) {
+            refill();
+        }
+        const int move = static_cast<int>(digits_ % 9);
+        digits_ /= 9;
+        left_--;
+        return move;
+    }
+
+    void next(int& dx, int& dy) {
+        const int move = next();
+        dx = move / 3 - 1;
+        dy = move % 3 - 1;
+    }
+
+private:
+    void refill() {
+        while (true) {
+            if (!spare_) {
+                word_ = engine_();
+                spare_ = true;
+                if (static_cast<std::uint32_t>(word_) < NINE_TO_THE_TEN) {
+                    digits_ = static_cast<std::uint32_t>(word_);
+                    left_ = 10;
+                    return;
+                }
+            }
+            spare_ = false;
+            if (static_cast<std::uint32_t>(word_ >> 32) < NINE_TO_THE_TEN) {
+                digits_ = static_cast<std::uint32_t>(word_ >> 32);
+                left_ = 10;
+                return;
+            }
+        }
+    }
+
+    G& engine_;
+    std::uint64_t word_ = 0;
+    bool spare_ = false;
+    std::uint32_t digits_ = 0;
+    int left_ = 0;
+};
+
+/**********************************************************************
+ * prints chi-square tests that harvested moves are uniform over the 9
+ * moves and over the 81 pairs of consecutive moves
+***********************************************************************/
+template <typename G>
+void checkMoves(G& generator, const long draws, std::ostream& out) {
+    MoveHarvester<G> moves(generator);
+    std::vector<long> singles(9, 0);
+    std::vector<long> pairs(81, 0);
+    int previous = moves.next();
+    for (long i = 0; i < draws; i++) {
+        const int move = moves.next();
+        singles[move]++;
+        pairs[previous * 9 + move]++;
+        previous = move;
+    }
+    double single = 0;
+    for (const long count : singles) {
+        const double expected = draws / 9.0;
+        single += (count - expected) * (count - expected) / expected;
+    }
+    double pair = 0;
+    for (const long count : pairs) {
+        const double expected = draws / 81.0;
+        pair += (count - expected) * (count - expected) / expected;
+    }
+    out << "moves: chi-square " << single << " on 8 degrees of freedom" << std::endl;
+    out << "move pairs: chi-square " << pair << " on 80 degrees of freedom" << std::endl;
+}
+
+#endif
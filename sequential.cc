@@ -1,17 +1,33 @@
 #include <algorithm>
 #include <chrono>
+#include <deque>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <random>
 #include <regex>
 #include <tuple>
+#include <vector>
+
+#include "distance.h"
+#include "hops.h"
+#include "lattice.h"
+#include "launch.h"
+#include "offlattice.h"
+#include "options.h"
+#include "producer.h"
+#include "pyramid.h"
+#include "rng.h"
+#include "simd.h"
+#include "walk.h"
 
 /**********************************************************************
  * generates a random point outside of the radius of the crystal
 ***********************************************************************/
-std::tuple<int, int> generatePoint(std::default_random_engine& generator, const int gridSize, const int center, const int radius) {
+template <typename G>
+std::tuple<int, int> generatePoint(G& generator, const int gridSize, const int center, const int radius) {
     std::uniform_int_distribution<int> distribution(0, gridSize - 1);
     int x, y;
     do {
@@ -24,70 +40,348 @@ std::tuple<int, int> generatePoint(std::default_random_engine& generator, const
 /**********************************************************************
  * calculates the next random move for a particle
  * 
- * note: the next move could cause particle to leave the lattice
+ * note: the next move could cause particle to leave the lattice; moves
+ * are harvested many at a time from 64-bit engine outputs, or taken
+ * from a producer thread's ring
 ***********************************************************************/
-std::tuple<int, int> nextMove(std::default_random_engine& generator) {
-    std::uniform_int_distribution<int> distribution(-1, 1);
-    int dx = distribution(generator);
-    int dy = distribution(generator);
+template <typename M>
+std::tuple<int, int> nextMove(M& moves) {
+    int dx, dy;
+    moves.next(dx, dy);
     return std::make_tuple(dx, dy);
 }
 
 /* determines if the current particle should stick to the crystal */
-bool shouldStick(std::vector<std::vector<char>>& grid, const int gridSize, const int x, const int y) {
-    for (int dx = -1; dx <= 1; dx++) {
-        for (int dy = -1; dy <= 1; dy++) {
-            const int newX = x + dx;
-            const int newY = y + dy;
-            if (newX >= 0 && newX < gridSize && newY >= 0 && newY < gridSize) {
-                if (grid[newX][newY] == 'X') {
-                    return true;
+template <typename L>
+bool shouldStick(const L& grid, const int x, const int y) {
+    return grid.touchesCrystal(x, y);
+}
+
+/**********************************************************************
+ * walks particle until it leaves lattice or sticks to the crystal
+***********************************************************************/
+template <typename G, typename M, typename L>
+void walkParticle(G& generator, M& moves, L& grid, const WalkSettings& walk, int& x, int& y) {
+
+    /* steps the particle can take before it could reach the crystal */
+    int safeSteps = 0;
+    while (grid.contains(x, y)) {
+        bool moved = false;
+        if (safeSteps > 0) {
+            safeSteps--;
+        } else {
+            /* check if should stick */
+            if (shouldStick(grid, x, y)) {
+                grid.place(x, y);
+                recordStick(walk, x, y);
+                return;
+            }
+
+            /* cross empty space in one move when far enough from the crystal */
+            if (walk.mode == WalkMode::JUMP) {
+                const double reach = jumpRadius(walk, grid.size(), x, y);
+                if (reach >= MIN_JUMP) {
+                    jumpOnCircle(generator, reach, x, y);
+                    moved = true;
+                }
+            } else if (walk.mode == WalkMode::HOP) {
+                const int level = DisplacementTables::levelFor(squareClearance(walk, grid.size(), x, y));
+                if (level > 0) {
+                    walk.hops->hop(generator, level, x, y);
+                    moved = true;
+                }
+            } else if (walk.mode == WalkMode::SQUARE) {
+                const int index = walk.exits->indexFor(squareClearance(walk, grid.size(), x, y));
+                if (index >= 0) {
+                    walk.exits->exit(generator, index, x, y);
+                    moved = true;
                 }
             }
+
+            /* within r steps of an empty square of radius r nothing is reachable */
+            if (!moved && walk.pyramid != nullptr) {
+                safeSteps = walk.pyramid->emptyRadius(x, y) - 1;
+            }
+        }
+
+        if (!moved) {
+            /* generate next move */
+            const std::tuple<int, int> direction = nextMove(moves);
+            const int dx = std::get<0>(direction);
+            const int dy = std::get<1>(direction);
+
+            x += dx;
+            y += dy;
+        }
+
+        /* return strays to the launch circle */
+        if (walk.kill != nullptr && walk.kill->outside(x, y)) {
+            walk.kill->returnWalker(generator, x, y);
+            safeSteps = 0;
         }
     }
-    return false;
 }
 
 /**********************************************************************
- * walks particle until it leaves lattice or sticks to the crystal
+ * launches a particle around a crystal of radius walk.radius and walks
+ * it until it leaves the lattice or sticks, leaving (x, y) where it
+ * stopped
+ *
+ * note: lattice steps come from walk.kernel or else ring if either is
+ * not nullptr, otherwise they are harvested from generator like every
+ * other draw
+***********************************************************************/
+template <typename G, typename L>
+void runParticle(const Options& options, L& grid, const WalkSettings& walk, G& generator, RingMoves* ring, int& x, int& y) {
+    /* generate point, on the launch circle if requested and it fits */
+    const double launch = launchRadius(walk.radius);
+    const auto point = options.inject == "circle" && circleFits(walk.center, launch)
+        ? pointOnCircle(generator, walk.center, launch)
+        : generatePoint(generator, grid.size(), walk.center, walk.radius);
+    x = std::get<0>(point);
+    y = std::get<1>(point);
+
+    /* kill circle, if requested and it fits */
+    const KillCircle kill = {walk.center, launch, options.kill * launch};
+    const bool killing = options.kill > 1 && circleFits(walk.center, kill.killRadius);
+
+    /* walk particle until it leaves lattice or sticks to the crystal */
+    WalkSettings settings = walk;
+    settings.kill = killing ? &kill : nullptr;
+    if (walk.kernel != nullptr) {
+        KernelMoves<G> moves(*walk.kernel, generator);
+        walkParticle(generator, moves, grid, settings, x, y);
+    } else if (ring != nullptr) {
+        walkParticle(generator, *ring, grid, settings, x, y);
+    } else {
+        MoveHarvester<G> moves(generator);
+        walkParticle(generator, moves, grid, settings, x, y);
+    }
+}
+
+/* steps between the checkpoints a batch walker can be rewound to */
+const int CHECKPOINT_STEPS = 256;
+
+/* start of a stretch of a batch walker's path and the box it covered */
+struct Checkpoint {
+    int x, y;
+    std::uint32_t engine;
+    int lowX, highX, lowY, highY;
+};
+
+/**********************************************************************
+ * walks numParticles particles in lockstep batches of up to batch
+ * walkers, with results distributed as if they walked one at a time
+ *
+ * note: positions and engine states live in separate arrays and each
+ * round first runs stepLanes over the whole batch, which draws every
+ * walker's move and issues every sticking test before any result is
+ * used, 8 or 16 walkers per instruction where the CPU allows, so their
+ * loads overlap. Each walker has its own engine and stops when it
+ * touches the crystal or leaves the lattice, but only the oldest walker
+ * is ever committed. Every CHECKPOINT_STEPS steps a walker saves its
+ * position, engine and the bounding box of the stretch since the last
+ * checkpoint; a stick next to a younger walker's path rewinds it to the
+ * start of the first stretch it touched, so it replays the same steps
+ * against the grown crystal exactly as the sequential loop would have
+ * walked them. A launch point the grown crystal has overtaken is
+ * redrawn. Only single steps are taken; structures supplies the center,
+ * pyramid and distance field to update.
 ***********************************************************************/
-void walkParticle(std::default_random_engine& generator, std::vector<std::vector<char>>& grid, const int gridSize, int& x, int& y) {
-    while (x >= 0 && x < gridSize && y >= 0 && y < gridSize) {
-        /* check if should stick */
-        if (shouldStick(grid, gridSize, x, y)) {
-            grid[x][y] = 'X';
-            return;
+template <typename L>
+void walkBatch(Xoshiro256& generator, L& grid, const Options& options, const WalkSettings& structures, int& radius, const unsigned long numParticles) {
+    const int gridSize = grid.size();
+    const int center = structures.center;
+    const std::size_t batch = static_cast<std::size_t>(std::min<unsigned long>(options.batch, numParticles));
+
+    /* walker state, one entry per slot */
+    const Isa isa = isaNamed(options.simd);
+    std::vector<char> state(batch, EMPTY);
+    std::vector<int> xs(batch), ys(batch), steps(batch);
+    std::vector<int> startXs(batch), startYs(batch);
+    std::vector<double> launches(batch);
+    std::vector<char> circles(batch);
+    std::vector<std::uint32_t> engines(batch);
+
+    /* the stretch being walked, and the earlier ones with their union box */
+    std::vector<Checkpoint> current(batch);
+    std::vector<std::vector<Checkpoint>> history(batch);
+    std::vector<int> lowXs(batch), highXs(batch), lowYs(batch), highYs(batch);
+
+    /* slots in launch order, oldest first */
+    std::deque<std::size_t> order;
+
+    /* rewinds slot j to the start of its stretch i */
+    auto rewind = [&](const std::size_t j, const std::size_t i) {
+        if (i < history[j].size()) {
+            current[j] = history[j][i];
+            history[j].resize(i);
         }
+        Checkpoint& stretch = current[j];
+        state[j] = WALKING;
+        steps[j] = 0;
+        xs[j] = stretch.lowX = stretch.highX = stretch.x;
+        ys[j] = stretch.lowY = stretch.highY = stretch.y;
+        engines[j] = stretch.engine;
+        lowXs[j] = lowYs[j] = gridSize;
+        highXs[j] = highYs[j] = -1;
+        for (const Checkpoint& earlier : history[j]) {
+            lowXs[j] = std::min(lowXs[j], earlier.lowX);
+            highXs[j] = std::max(highXs[j], earlier.highX);
+            lowYs[j] = std::min(lowYs[j], earlier.lowY);
+            highYs[j] = std::max(highYs[j], earlier.highY);
+        }
+    };
 
-        /* generate next move */
-        const std::tuple<int, int> direction = nextMove(generator);
-        const int dx = std::get<0>(direction);
-        const int dy = std::get<1>(direction);
+    /* draws a launch point for slot j around the current crystal */
+    auto relaunch = [&](const std::size_t j) {
+        engines[j] = static_cast<std::uint32_t>(generator() % (MINSTD_MODULUS - 1) + 1);
+        LaneEngine engine(engines[j]);
+        launches[j] = launchRadius(radius);
+        circles[j] = options.inject == "circle" && circleFits(center, launches[j]);
+        const auto point = circles[j]
+            ? pointOnCircle(engine, center, launches[j])
+            : generatePoint(engine, gridSize, center, radius);
+        startXs[j] = std::get<0>(point);
+        startYs[j] = std::get<1>(point);
+        history[j].clear();
+        current[j].x = startXs[j];
+        current[j].y = startYs[j];
+        current[j].engine = engines[j];
+        rewind(j, 0);
+    };
 
-        x += dx;
-        y += dy;
+    /* no particle is launched once the crystal fills the grid */
+    if (radius >= gridSize / 2 - 1) {
+        return;
+    }
+    unsigned long launched = 0;
+    for (std::size_t j = 0; j < batch; j++) {
+        relaunch(j);
+        order.push_back(j);
+        launched++;
+    }
+
+    while (!order.empty()) {
+        /* stop every walker touching the crystal and move the others */
+        stepLanes(grid, isa, engines.data(), xs.data(), ys.data(), state.data(), batch);
+
+        for (std::size_t j = 0; j < batch; j++) {
+            if (state[j] != WALKING) {
+                continue;
+            }
+            if (!grid.contains(xs[j], ys[j])) {
+                state[j] = LEFT;
+                continue;
+            }
+
+            /* return strays to the launch circle */
+            if (options.kill > 1 && circles[j]) {
+                const KillCircle kill = {center, launches[j], options.kill * launches[j]};
+                if (circleFits(center, kill.killRadius) && kill.outside(xs[j], ys[j])) {
+                    LaneEngine engine(engines[j]);
+                    kill.returnWalker(engine, xs[j], ys[j]);
+                }
+            }
+
+            /* extend the stretch, or start a new one */
+            Checkpoint& stretch = current[j];
+            if (++steps[j] < CHECKPOINT_STEPS) {
+                stretch.lowX = std::min(stretch.lowX, xs[j]);
+                stretch.highX = std::max(stretch.highX, xs[j]);
+                stretch.lowY = std::min(stretch.lowY, ys[j]);
+                stretch.highY = std::max(stretch.highY, ys[j]);
+            } else {
+                history[j].push_back(stretch);
+                lowXs[j] = std::min(lowXs[j], stretch.lowX);
+                highXs[j] = std::max(highXs[j], stretch.highX);
+                lowYs[j] = std::min(lowYs[j], stretch.lowY);
+                highYs[j] = std::max(highYs[j], stretch.highY);
+                steps[j] = 0;
+                stretch = {xs[j], ys[j], engines[j], xs[j], xs[j], ys[j], ys[j]};
+            }
+        }
+
+        /* commit stopped walkers in launch order */
+        while (!order.empty() && state[order.front()] != WALKING) {
+            const std::size_t j = order.front();
+            order.pop_front();
+            if (state[j] == STUCK) {
+                const int x = xs[j];
+                const int y = ys[j];
+                grid.place(x, y);
+                recordStick(structures, x, y);
+                radius = std::max(radius, std::max(std::abs(center - x), std::abs(center - y)));
+                reserveRadius(grid, radius + 1);
+
+                /* whether a box comes within one cell of the new crystal cell */
+                auto near = [x, y](const int lowX, const int highX, const int lowY, const int highY) {
+                    return lowX <= x + 1 && highX >= x - 1 && lowY <= y + 1 && highY >= y - 1;
+                };
+                for (const std::size_t k : order) {
+                    /* younger walkers are dropped below once the crystal fills the
+                       grid, and no launch point would be clear of it */
+                    if (radius >= gridSize / 2 - 1) {
+                        break;
+                    }
+
+                    /* a launch point must stay clear of the crystal's bounding square */
+                    const bool overtaken = circles[k]
+                        ? launches[k] <= (radius + 1) * std::sqrt(2.0)
+                        : std::abs(center - startXs[k]) <= radius + 1 && std::abs(center - startYs[k]) <= radius + 1;
+                    if (overtaken) {
+                        relaunch(k);
+                        continue;
+                    }
+
+                    /* find the first stretch that came near, if any */
+                    std::size_t i = history[k].size();
+                    if (near(lowXs[k], highXs[k], lowYs[k], highYs[k])) {
+                        i = 0;
+                        while (i < history[k].size() && !near(history[k][i].lowX, history[k][i].highX, history[k][i].lowY, history[k][i].highY)) {
+                            i++;
+                        }
+                    }
+                    if (i < history[k].size() || near(current[k].lowX, current[k].highX, current[k].lowY, current[k].highY)) {
+                        rewind(k, i);
+                    }
+                }
+            }
+
+            /* the next particle would not be launched once the crystal fills the grid */
+            if (radius >= gridSize / 2 - 1) {
+                order.clear();
+                break;
+            }
+            state[j] = EMPTY;
+            if (launched < numParticles) {
+                relaunch(j);
+                order.push_back(j);
+                launched++;
+            }
+        }
     }
 }
 
 /**********************************************************************
  * write result to file
+ *
+ * note: only rows and columns in [low, high) are written; cells hold 1
+ * for the crystal, or the attachment index with --lattice=order
 ***********************************************************************/
-void writeToFile(const std::vector<std::vector<char>>& grid, const int gridSize) {
+template <typename L>
+void writeToFile(const L& grid, const int low, const int high) {
     std::ofstream myfile;
     myfile.open("sequential_result.txt");
-    for (int i = 0; i < gridSize; i++) {
-        for (int k = 0; k < gridSize; k++) {
-            int value = 0;
-            if (grid[i][k] != 0) {
-                value = 1;
-            }
-            if (k != 0) {
+    for (int i = low; i < high; i++) {
+        for (int k = low; k < high; k++) {
+            const std::uint32_t value = cellValue(grid, i, k);
+            if (k != low) {
                 myfile << ",";
             }
             myfile << value;
         }
-        if (i != gridSize - 1) {
+        if (i != high - 1) {
             myfile << "\n";
         }
     }
@@ -97,13 +391,14 @@ void writeToFile(const std::vector<std::vector<char>>& grid, const int gridSize)
 /**********************************************************************
  * print crude result visual to console
 ***********************************************************************/
-void consoleVisual(const std::vector<std::vector<char>>& grid, const int gridSize) {
+template <typename L>
+void consoleVisual(const L& grid, const int gridSize) {
     /* print crude depiction of final crystal inside lattice */
     for (int i = 0; i < gridSize; i++) {
         for (int k = 0; k < gridSize; k++) {
-            char value = grid[i][k];
-            if (value == 0) {
-                value = '-';
+            char value = '-';
+            if (grid.occupied(i, k)) {
+                value = 'X';
             }
             std::cout << value << " ";
         }
@@ -112,12 +407,205 @@ void consoleVisual(const std::vector<std::vector<char>>& grid, const int gridSiz
 }
 
 /**********************************************************************
- * main function to manage crystal, lattice, and particles sequentially
+ * manages crystal, lattice, and particles sequentially on lattice type L
+***********************************************************************/
+template <typename L>
+void simulate(const Options& options, const int gridSize, const unsigned long numParticles) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    L grid(gridSize);
+
+    /* initialize radius and center */
+    int radius = 0;
+    const int center = gridSize / 2;
+
+    /* create occupancy pyramid if requested */
+    std::unique_ptr<OccupancyPyramid> pyramid;
+    if (options.pyramid) {
+        pyramid.reset(new OccupancyPyramid(gridSize));
+    }
+
+    /* create distance field if requested */
+    std::unique_ptr<DistanceField> distance;
+    if (options.distance) {
+        distance.reset(new DistanceField(gridSize));
+    }
+
+    /* build multi-step displacement tables if requested */
+    std::unique_ptr<DisplacementTables> hops;
+    if (options.walk == "hop") {
+        hops.reset(new DisplacementTables());
+    }
+
+    /* build exit distributions of empty squares if requested */
+    std::unique_ptr<ExitTables> exits;
+    if (options.walk == "square") {
+        exits.reset(new ExitTables());
+    }
+
+    /* build the move kernel of a biased walk if requested */
+    std::unique_ptr<MoveKernel> kernel;
+    if (biasedWalk(options)) {
+        kernel.reset(new MoveKernel(kernelWeights(options.moves, options.weights, options.driftX, options.driftY)));
+    }
+
+    /* place starting crystal */
+    grid.place(center, center);
+    if (pyramid) {
+        pyramid->mark(center, center);
+    }
+    if (distance) {
+        distance->update(center, center);
+    }
+
+    /* seed from the options or the system clock; the xoshiro256** engine
+       serves every particle with --rng=xoshiro and seeds batch lanes */
+    const std::uint64_t seed = runSeed(options);
+    Xoshiro256 engine(seed);
+    const bool xoshiro = options.rng == "xoshiro";
+
+    /* walk particles in lockstep batches if requested */
+    if (options.batch > 0) {
+        const WalkSettings structures = {center, radius, nullptr, pyramid.get(), distance.get(), nullptr, nullptr, nullptr, WalkMode::STEP, nullptr, nullptr};
+        walkBatch(engine, grid, options, structures, radius, numParticles);
+    }
+
+    /* a thread drawing moves ahead of the walker, if requested */
+    std::unique_ptr<MoveProducer> producer;
+    std::unique_ptr<RingMoves> ring;
+    if (options.producers && options.batch == 0) {
+        producer.reset(new MoveProducer(seed, 1));
+        ring.reset(new RingMoves(producer->ring()));
+    }
+
+    /* sequentially run each particle through its journey in the lattice */
+    for (unsigned long p = 0; options.batch == 0 && p < numParticles; p++) {
+        /* check if radius is the entire grid */
+        if (radius >= gridSize / 2 - 1) {
+            break;
+        }
+
+        /* a stuck particle extends the radius by at most one */
+        reserveRadius(grid, radius + 1);
+
+        /* walk particle until it leaves lattice or sticks to the crystal */
+        const WalkSettings walk = {center, radius, nullptr, pyramid.get(), distance.get(), hops.get(), exits.get(), nullptr, walkMode(options.walk), kernel.get(), nullptr};
+        int x, y;
+        if (xoshiro) {
+            runParticle(options, grid, walk, engine, ring.get(), x, y);
+        } else {
+            /* each particle walks on its own stream, as in parallel.cc */
+            Philox generator(seed, p);
+            runParticle(options, grid, walk, generator, ring.get(), x, y);
+        }
+
+        /* check if particle stuck, if it did update radius if necessary */
+        if (grid.contains(x, y)) {
+            const int distance = std::max(std::abs(center - x), std::abs(center - y));
+            if (distance > radius) {
+                radius = distance;
+            }
+        }
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    
+    std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() / 1000.0 << " s" << std::endl;
+
+    if (options.crop) {
+        const int margin = std::min(radius + 1, center);
+        writeToFile(grid, center - margin, center + margin + 1);
+    } else {
+        writeToFile(grid, 0, gridSize);
+    }
+}
+
+/**********************************************************************
+ * grows an off-lattice cluster of unit-diameter disks sequentially, then
+ * writes it rasterized onto lattice type L
+ *
+ * note: disks start on the launch circle around the cluster's bounding
+ * circle; the rasterized cell of each disk is its rounded center, in
+ * attachment order
+***********************************************************************/
+template <typename L>
+void simulateOffLattice(const Options& options, const int gridSize, const unsigned long numParticles) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    /* the launch circle must fit, so the cluster stays inside a disk of
+       diameter gridSize and never holds more than gridSize^2 disks */
+    const int center = gridSize / 2;
+    DiskCluster cluster(gridSize, std::min(static_cast<std::size_t>(numParticles) + 1, static_cast<std::size_t>(gridSize) * gridSize));
+    cluster.add(center, center);
+
+    /* seed from the options or the system clock */
+    const std::uint64_t seed = runSeed(options);
+    Xoshiro256 engine(seed);
+
+    /* sequentially run each disk through its journey in the domain */
+    for (unsigned long p = 0; p < numParticles; p++) {
+        /* check if the launch circle still fits in the domain */
+        const double launch = cluster.radius() + LAUNCH_GAP;
+        if (!circleFits(center, launch)) {
+            break;
+        }
+
+        /* walk disk until it leaves the domain or touches the cluster */
+        if (options.rng == "xoshiro") {
+            runDisk(engine, cluster, center, launch, options.kill);
+        } else {
+            Philox generator(seed, p);
+            runDisk(generator, cluster, center, launch, options.kill);
+        }
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() / 1000.0 << " s" << std::endl;
+
+    /* rasterize the disks in attachment order */
+    const int radius = static_cast<int>(std::ceil(cluster.radius()));
+    L grid(gridSize);
+    reserveRadius(grid, radius + 1);
+    for (std::size_t i = 0; i < cluster.count(); i++) {
+        const int x = static_cast<int>(std::lround(cluster.x(i)));
+        const int y = static_cast<int>(std::lround(cluster.y(i)));
+        if (grid.contains(x, y) && !grid.occupied(x, y)) {
+            grid.place(x, y);
+        }
+    }
+
+    if (options.crop) {
+        const int margin = std::min(radius + 1, center);
+        writeToFile(grid, center - margin, center + margin + 1);
+    } else {
+        writeToFile(grid, 0, gridSize);
+    }
+}
+
+/**********************************************************************
+ * runs the simulation on lattice type L, with or without the sticky mask
+ *
+ * note: the off-lattice model only uses L to write its result
+***********************************************************************/
+template <typename L>
+void simulateWith(const Options& options, const int gridSize, const unsigned long numParticles) {
+    if (options.model == "offlattice") {
+        simulateOffLattice<L>(options, gridSize, numParticles);
+    } else if (options.sticky) {
+        simulate<StickyLattice<L>>(options, gridSize, numParticles);
+    } else {
+        simulate<L>(options, gridSize, numParticles);
+    }
+}
+
+/**********************************************************************
+ * main function to parse arguments and select the lattice type
 ***********************************************************************/
 int main(int argc, char* argv[]) {
     /* check for proper arguments */
-    if (argc != 3) {
-        std::cerr << "Requires one argument\n\nUsage:\n\t./sequential <grid_size> <num_particles>" << std::endl;
+    if (argc < 3) {
+        std::cerr << "Requires two arguments\n\nUsage:\n\t./sequential <grid_size> <num_particles> [options]\n\nOptions:\n" << OPTIONS_USAGE << std::endl;
         exit(EXIT_FAILURE);
     }
 
@@ -147,54 +635,46 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    auto start_time = std::chrono::high_resolution_clock::now();
-
     const int gridSize = tempSize;
     const unsigned long numParticles = tempParticles;
 
-    std::vector<std::vector<char>> grid(gridSize, std::vector<char>(gridSize));
-
-    /* initialize radius and center */
-    int radius = 0;
-    const int center = gridSize / 2;
-
-    /* place starting crystal */
-    grid[center][center] = 'X';
-
-    /* create random number generator */
-    std::default_random_engine generator;
-
-    /* seed generator with system clock */
-    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-    generator.seed(seed);
-
-    /* sequentially run each particle through its journey in the lattice */
-    for (unsigned long p = 0; p < numParticles; p++) {
-        /* check if radius is the entire grid */
-        if (radius >= gridSize / 2 - 1) {
-            break;
-        }
-
-        /* generate point */
-        const auto point = generatePoint(generator, gridSize, center, radius);
-        int x = std::get<0>(point);
-        int y = std::get<1>(point);
+    /* parse optional arguments */
+    Options options;
+    if (!parseOptions(argc, argv, 3, false, options)) {
+        exit(EXIT_FAILURE);
+    }
+    allocationPolicy().hugePages = options.hugePages;
 
-        /* walk particle until it leaves lattice or sticks to the crystal */
-        walkParticle(generator, grid, gridSize, x, y);
+    /* time the batch walker kernels if requested */
+    if (options.benchmark) {
+        benchmarkLanes<Lattice>("char", gridSize, std::cout);
+        benchmarkLanes<StickyLattice<Lattice>>("sticky", gridSize, std::cout);
+        benchmarkMoves(std::cout);
+    }
 
-        /* check if particle stuck, if it did update radius if necessary */
-        if (x >= 0 && x < gridSize && y >= 0 && y < gridSize) {
-            const int distance = std::max(std::abs(center - x), std::abs(center - y));
-            if (distance > radius) {
-                radius = distance;
-            }
+    /* check the walk tables against simulated single steps if requested */
+    if (options.check) {
+        Philox generator(std::chrono::system_clock::now().time_since_epoch().count(), 0);
+        checkMoves(generator, 9000000, std::cout);
+        DisplacementTables().check(generator, 100000, std::cout);
+        if (biasedWalk(options)) {
+            checkKernel(MoveKernel(kernelWeights(options.moves, options.weights, options.driftX, options.driftY)), generator, 9000000, std::cout);
         }
     }
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    
-    std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() / 1000.0 << " s" << std::endl;
-
-    writeToFile(grid, gridSize);
+    if (options.lattice == "bits") {
+        simulateWith<BitLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "padded") {
+        simulateWith<PaddedLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "morton") {
+        simulateWith<MortonLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "sparse") {
+        simulateWith<SparseLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "order") {
+        simulateWith<OrderLattice>(options, gridSize, numParticles);
+    } else if (options.lattice == "growing") {
+        simulateWith<GrowingLattice>(options, gridSize, numParticles);
+    } else {
+        simulateWith<Lattice>(options, gridSize, numParticles);
+    }
 }
\ No newline at end of file
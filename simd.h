@@ -0,0 +1,412 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <immintrin.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lattice.h"
+
+/* instruction sets the batch walker kernel can use, in increasing order */
+enum class Isa {SCALAR, AVX2, AVX512};
+
+/* the best instruction set this CPU supports, at most limit */
+inline Isa supportedIsa(const Isa limit = Isa::AVX512) {
+    __builtin_cpu_init();
+    if (limit >= Isa::AVX512 && __builtin_cpu_supports("avx512f")) {
+        return Isa::AVX512;
+    }
+    if (limit >= Isa::AVX2 && __builtin_cpu_supports("avx2")) {
+        return Isa::AVX2;
+    }
+    return Isa::SCALAR;
+}
+
+/* converts the --simd option to an Isa, falling back to what the CPU supports */
+inline Isa isaNamed(const std::string& name) {
+    if (name == "scalar") {
+        return Isa::SCALAR;
+    }
+    if (name == "avx2") {
+        return supportedIsa(Isa::AVX2);
+    }
+    return supportedIsa();
+}
+
+inline const char* isaName(const Isa isa) {
+    return isa == Isa::AVX512 ? "avx512" : isa == Isa::AVX2 ? "avx2" : "scalar";
+}
+
+/* state of a batch walker slot */
+enum LaneState : char {EMPTY, WALKING, STUCK, LEFT};
+
+/* std::minstd_rand0, the default_random_engine of libstdc++ */
+const std::uint32_t MINSTD_MULTIPLIER = 16807;
+const std::uint32_t MINSTD_MODULUS = 2147483647;
+
+/* outputs of minstd at or past this are rejected when drawing -1, 0 or +1 */
+const std::uint32_t MOVE_PAST = 2147483643;
+const std::uint32_t MOVE_SCALING = 715827881;
+
+/**********************************************************************
+ * std::minstd_rand0 stepping a state held in a batch array
+ *
+ * note: lets the per-walker states live in one array the vector
+ * kernels load whole, while the scalar code still hands the walker to
+ * std distributions as an ordinary engine
+***********************************************************************/
+class LaneEngine {
+public:
+    using result_type = std::uint32_t;
+
+    explicit LaneEngine(std::uint32_t& state) : state_(state) {}
+
+    static constexpr result_type min() {
+        return 1;
+    }
+
+    static constexpr result_type max() {
+        return MINSTD_MODULUS - 1;
+    }
+
+    result_type operator()() {
+        state_ = static_cast<std::uint32_t>(static_cast<std::uint64_t>(state_) * MINSTD_MULTIPLIER % MINSTD_MODULUS);
+        return state_;
+    }
+
+private:
+    std::uint32_t& state_;
+};
+
+/* draws -1, 0 or +1 the way uniform_int_distribution(-1, 1) does from minstd */
+inline int laneMove(std::uint32_t& state) {
+    LaneEngine engine(state);
+    std::uint32_t value;
+    do {
+        value = engine() - 1;
+    } while (value >= MOVE_PAST);
+    return static_cast<int>(value / MOVE_SCALING) - 1;
+}
+
+/**********************************************************************
+ * byte lattice rows as seen by the vector kernels
+ *
+ * note: rows is 3 when a walker touches the crystal if any of the 3x3
+ * cells around it is set, 1 when the cell itself is a sticky mask
+***********************************************************************/
+struct ByteView {
+    const char* cells;
+    std::size_t stride;
+    int size;
+    int rows;
+};
+
+/* whether a lattice is byte rows the kernels can gather from */
+template <typename L>
+bool byteView(const L&, ByteView&) {
+    return false;
+}
+
+/**********************************************************************
+ * the byte rows of a plain lattice
+ *
+ * note: gathers load 4 bytes from 32-bit offsets; an odd size leaves at
+ * least one padding byte per row, so a row read starting at y - 1 for
+ * y <= size - 2 stays inside its row
+***********************************************************************/
+inline bool byteView(const Lattice& grid, ByteView& view) {
+    view = {grid.cells(), grid.stride(), grid.size(), 3};
+    return grid.stride() > static_cast<std::size_t>(grid.size()) && grid.stride() * grid.size() < 0x80000000u;
+}
+
+/* the byte rows of the sticky mask, where one cell answers the test */
+inline bool byteView(const StickyLattice<Lattice>& grid, ByteView& view) {
+    const bool usable = byteView(grid.mask(), view);
+    view.rows = 1;
+    return usable;
+}
+
+/* the sticking test of a view, with bounds checks, for lanes at the edge */
+inline bool viewTouches(const ByteView& view, const int x, const int y) {
+    if (view.rows == 1) {
+        return view.cells[static_cast<std::size_t>(x) * view.stride + y] != 0;
+    }
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            const int newX = x + dx;
+            const int newY = y + dy;
+            if (newX >= 0 && newX < view.size && newY >= 0 && newY < view.size && view.cells[static_cast<std::size_t>(newX) * view.stride + newY] != 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**********************************************************************
+ * one round for walkers first .. last - 1: every WALKING walker draws a
+ * move, and is marked STUCK if it touches the crystal or else moves
+***********************************************************************/
+template <typename L>
+void stepLanesScalar(const L& grid, std::uint32_t* states, int* xs, int* ys, char* lanes, const std::size_t first, const std::size_t last) {
+    for (std::size_t j = first; j < last; j++) {
+        if (lanes[j] != WALKING) {
+            continue;
+        }
+        const int dx = laneMove(states[j]);
+        const int dy = laneMove(states[j]);
+        if (grid.touchesCrystal(xs[j], ys[j])) {
+            lanes[j] = STUCK;
+        } else {
+            xs[j] += dx;
+            ys[j] += dy;
+        }
+    }
+}
+
+/* minstd step of 8 states below 2^31, using only 32-bit lanes */
+__attribute__((target("avx2")))
+inline __m256i minstdNext(const __m256i states) {
+    const __m256i modulus = _mm256_set1_epi32(MINSTD_MODULUS);
+    const __m256i multiplier = _mm256_set1_epi32(MINSTD_MULTIPLIER);
+    /* s * a = low * a + high * a * 2^16, and 2^31 = 1 mod the modulus */
+    const __m256i low = _mm256_mullo_epi32(_mm256_and_si256(states, _mm256_set1_epi32(0xffff)), multiplier);
+    const __m256i high = _mm256_mullo_epi32(_mm256_srli_epi32(states, 16), multiplier);
+    const __m256i shifted = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(high, _mm256_set1_epi32(0x7fff)), 16), _mm256_srli_epi32(high, 15));
+    __m256i sum = _mm256_add_epi32(low, shifted);
+    sum = _mm256_add_epi32(_mm256_and_si256(sum, modulus), _mm256_srli_epi32(sum, 31));
+    return _mm256_min_epu32(sum, _mm256_sub_epi32(sum, modulus));
+}
+
+/* laneMove for the lanes set in need */
+__attribute__((target("avx2")))
+inline __m256i drawMoves(__m256i& states, __m256i need) {
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i value;
+    do {
+        states = _mm256_blendv_epi8(states, minstdNext(states), need);
+        value = _mm256_sub_epi32(states, one);
+        need = _mm256_and_si256(need, _mm256_cmpgt_epi32(value, _mm256_set1_epi32(MOVE_PAST - 1)));
+    } while (!_mm256_testz_si256(need, need));
+    /* compares are -1 when true */
+    const __m256i first = _mm256_cmpgt_epi32(value, _mm256_set1_epi32(MOVE_SCALING - 1));
+    const __m256i second = _mm256_cmpgt_epi32(value, _mm256_set1_epi32(2 * MOVE_SCALING - 1));
+    return _mm256_sub_epi32(_mm256_sub_epi32(_mm256_set1_epi32(-1), first), second);
+}
+
+/* stepLanesScalar for 8 walkers per instruction; returns the walkers done */
+__attribute__((target("avx2")))
+inline std::size_t stepLanesAvx2(const ByteView& view, std::uint32_t* states, int* xs, int* ys, char* lanes, const std::size_t count) {
+    const __m256i stride = _mm256_set1_epi32(static_cast<int>(view.stride));
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i edge = _mm256_set1_epi32(view.size - 2);
+    const __m256i cellMask = _mm256_set1_epi32(view.rows == 1 ? 0xff : 0xffffff);
+    const int* base = reinterpret_cast<const int*>(view.cells);
+    std::size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        const __m256i state = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(lanes + j)));
+        const __m256i walking = _mm256_cmpeq_epi32(state, _mm256_set1_epi32(WALKING));
+        if (_mm256_testz_si256(walking, walking)) {
+            continue;
+        }
+        __m256i engines = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states + j));
+        const __m256i dx = drawMoves(engines, walking);
+        const __m256i dy = drawMoves(engines, walking);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(states + j), engines);
+
+        /* gather the neighborhood of walkers clear of the lattice edge */
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + j));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + j));
+        const __m256i outside = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(one, x), _mm256_cmpgt_epi32(x, edge)),
+            _mm256_or_si256(_mm256_cmpgt_epi32(one, y), _mm256_cmpgt_epi32(y, edge)));
+        const __m256i inside = _mm256_andnot_si256(outside, walking);
+        __m256i cells;
+        if (view.rows == 1) {
+            const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(x, stride), y);
+            cells = _mm256_mask_i32gather_epi32(zero, base, index, inside, 1);
+        } else {
+            const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(x, one), stride), _mm256_sub_epi32(y, one));
+            cells = _mm256_mask_i32gather_epi32(zero, base, index, inside, 1);
+            cells = _mm256_or_si256(cells, _mm256_mask_i32gather_epi32(zero, base, _mm256_add_epi32(index, stride), inside, 1));
+            cells = _mm256_or_si256(cells, _mm256_mask_i32gather_epi32(zero, base, _mm256_add_epi32(index, _mm256_add_epi32(stride, stride)), inside, 1));
+        }
+        int touching = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(cells, cellMask), zero), inside)));
+        int edgeLanes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(outside, walking)));
+        for (; edgeLanes != 0; edgeLanes &= edgeLanes - 1) {
+            const int lane = __builtin_ctz(edgeLanes);
+            if (viewTouches(view, xs[j + lane], ys[j + lane])) {
+                touching |= 1 << lane;
+            }
+        }
+
+        /* move the walkers that did not stick */
+        const __m256i stuck = _mm256_cmpgt_epi32(_mm256_and_si256(_mm256_set1_epi32(touching), _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)), zero);
+        const __m256i moving = _mm256_andnot_si256(stuck, walking);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(xs + j), _mm256_add_epi32(x, _mm256_and_si256(dx, moving)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ys + j), _mm256_add_epi32(y, _mm256_and_si256(dy, moving)));
+        for (; touching != 0; touching &= touching - 1) {
+            lanes[j + __builtin_ctz(touching)] = STUCK;
+        }
+    }
+    return j;
+}
+
+/* minstdNext for 16 states */
+__attribute__((target("avx512f")))
+inline __m512i minstdNext(const __m512i states) {
+    const __m512i modulus = _mm512_set1_epi32(MINSTD_MODULUS);
+    const __m512i multiplier = _mm512_set1_epi32(MINSTD_MULTIPLIER);
+    const __m512i low = _mm512_mullo_epi32(_mm512_and_si512(states, _mm512_set1_epi32(0xffff)), multiplier);
+    const __m512i high = _mm512_mullo_epi32(_mm512_srli_epi32(states, 16), multiplier);
+    const __m512i shifted = _mm512_add_epi32(_mm512_slli_epi32(_mm512_and_si512(high, _mm512_set1_epi32(0x7fff)), 16), _mm512_srli_epi32(high, 15));
+    __m512i sum = _mm512_add_epi32(low, shifted);
+    sum = _mm512_add_epi32(_mm512_and_si512(sum, modulus), _mm512_srli_epi32(sum, 31));
+    return _mm512_min_epu32(sum, _mm512_sub_epi32(sum, modulus));
+}
+
+/* drawMoves for 16 lanes */
+__attribute__((target("avx512f")))
+inline __m512i drawMoves(__m512i& states, __mmask16 need) {
+    const __m512i one = _mm512_set1_epi32(1);
+    __m512i value;
+    while (need != 0) {
+        states = _mm512_mask_blend_epi32(need, states, minstdNext(states));
+        value = _mm512_sub_epi32(states, one);
+        need = _mm512_mask_cmpgt_epi32_mask(need, value, _mm512_set1_epi32(MOVE_PAST - 1));
+    }
+    value = _mm512_sub_epi32(states, one);
+    __m512i move = _mm512_set1_epi32(-1);
+    move = _mm512_mask_add_epi32(move, _mm512_cmpgt_epi32_mask(value, _mm512_set1_epi32(MOVE_SCALING - 1)), move, one);
+    move = _mm512_mask_add_epi32(move, _mm512_cmpgt_epi32_mask(value, _mm512_set1_epi32(2 * MOVE_SCALING - 1)), move, one);
+    return move;
+}
+
+/* stepLanesScalar for 16 walkers per instruction; returns the walkers done */
+__attribute__((target("avx512f")))
+inline std::size_t stepLanesAvx512(const ByteView& view, std::uint32_t* states, int* xs, int* ys, char* lanes, const std::size_t count) {
+    const __m512i stride = _mm512_set1_epi32(static_cast<int>(view.stride));
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i edge = _mm512_set1_epi32(view.size - 2);
+    const __m512i cellMask = _mm512_set1_epi32(view.rows == 1 ? 0xff : 0xffffff);
+    std::size_t j = 0;
+    for (; j + 16 <= count; j += 16) {
+        const __m512i state = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes + j)));
+        const __mmask16 walking = _mm512_cmpeq_epi32_mask(state, _mm512_set1_epi32(WALKING));
+        if (walking == 0) {
+            continue;
+        }
+        __m512i engines = _mm512_loadu_si512(states + j);
+        const __m512i dx = drawMoves(engines, walking);
+        const __m512i dy = drawMoves(engines, walking);
+        _mm512_storeu_si512(states + j, engines);
+
+        /* gather the neighborhood of walkers clear of the lattice edge */
+        const __m512i x = _mm512_loadu_si512(xs + j);
+        const __m512i y = _mm512_loadu_si512(ys + j);
+        const __mmask16 inside = _mm512_mask_cmpge_epi32_mask(
+            _mm512_mask_cmple_epi32_mask(
+                _mm512_mask_cmpge_epi32_mask(
+                    _mm512_mask_cmple_epi32_mask(walking, x, edge), x, one), y, edge), y, one);
+        __m512i cells;
+        if (view.rows == 1) {
+            const __m512i index = _mm512_add_epi32(_mm512_mullo_epi32(x, stride), y);
+            cells = _mm512_mask_i32gather_epi32(zero, inside, index, view.cells, 1);
+        } else {
+            const __m512i index = _mm512_add_epi32(_mm512_mullo_epi32(_mm512_sub_epi32(x, one), stride), _mm512_sub_epi32(y, one));
+            cells = _mm512_mask_i32gather_epi32(zero, inside, index, view.cells, 1);
+            cells = _mm512_or_si512(cells, _mm512_mask_i32gather_epi32(zero, inside, _mm512_add_epi32(index, stride), view.cells, 1));
+            cells = _mm512_or_si512(cells, _mm512_mask_i32gather_epi32(zero, inside, _mm512_add_epi32(index, _mm512_add_epi32(stride, stride)), view.cells, 1));
+        }
+        __mmask16 touching = _mm512_mask_test_epi32_mask(inside, cells, cellMask);
+        for (unsigned edgeLanes = walking & ~inside; edgeLanes != 0; edgeLanes &= edgeLanes - 1) {
+            const int lane = __builtin_ctz(edgeLanes);
+            if (viewTouches(view, xs[j + lane], ys[j + lane])) {
+                touching |= static_cast<__mmask16>(1 << lane);
+            }
+        }
+
+        /* move the walkers that did not stick */
+        const __mmask16 moving = walking & ~touching;
+        _mm512_storeu_si512(xs + j, _mm512_mask_add_epi32(x, moving, x, dx));
+        _mm512_storeu_si512(ys + j, _mm512_mask_add_epi32(y, moving, y, dy));
+        for (unsigned stuck = touching; stuck != 0; stuck &= stuck - 1) {
+            lanes[j + __builtin_ctz(stuck)] = STUCK;
+        }
+    }
+    return j;
+}
+
+/**********************************************************************
+ * one round of the batch walker: every WALKING walker draws a move, and
+ * is marked STUCK if it touches the crystal or else moves
+ *
+ * note: byte lattices, plain or with a byte sticky mask, run 16 and
+ * then 8 walkers per instruction with the neighborhood read by gathers;
+ * the remaining walkers and other lattices take the scalar loop, which
+ * draws the same moves, so every variant gives the same walk
+***********************************************************************/
+template <typename L>
+void stepLanes(const L& grid, const Isa isa, std::uint32_t* states, int* xs, int* ys, char* lanes, const std::size_t count) {
+    std::size_t done = 0;
+    ByteView view;
+    if (isa != Isa::SCALAR && byteView(grid, view)) {
+        if (isa == Isa::AVX512) {
+            done = stepLanesAvx512(view, states, xs, ys, lanes, count);
+        }
+        done += stepLanesAvx2(view, states + done, xs + done, ys + done, lanes + done, count - done);
+    }
+    stepLanesScalar(grid, states, xs, ys, lanes, done, count);
+}
+
+/**********************************************************************
+ * prints steps per second of each kernel this CPU supports for 64
+ * walkers on an empty lattice of the given size, plain and sticky
+ *
+ * note: every variant starts from the same walkers, so equal position
+ * checksums show that they take the same walk
+***********************************************************************/
+template <typename L>
+void benchmarkLanes(const char* name, const int size, std::ostream& out) {
+    const std::size_t count = 64;
+    const int rounds = 200000;
+    L grid(size);
+    for (Isa isa = Isa::SCALAR; isa <= supportedIsa(); isa = static_cast<Isa>(static_cast<int>(isa) + 1)) {
+        std::default_random_engine generator(1);
+        std::uniform_int_distribution<int> position(1, size - 2);
+        std::vector<std::uint32_t> states(count);
+        std::vector<int> xs(count), ys(count);
+        std::vector<char> lanes(count, WALKING);
+        for (std::size_t j = 0; j < count; j++) {
+            states[j] = generator();
+            xs[j] = position(generator);
+            ys[j] = position(generator);
+        }
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            stepLanes(grid, isa, states.data(), xs.data(), ys.data(), lanes.data(), count);
+            /* fold walkers that reach the edge back to the middle */
+            for (std::size_t j = 0; j < count; j++) {
+                if (xs[j] < 1 || xs[j] > size - 2 || ys[j] < 1 || ys[j] > size - 2) {
+                    xs[j] = ys[j] = size / 2;
+                }
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::uint64_t checksum = 0;
+        for (std::size_t j = 0; j < count; j++) {
+            checksum = checksum * 31 + static_cast<std::uint64_t>(xs[j]) * size + ys[j];
+        }
+        out << name << " " << isaName(isa) << ": " << count * rounds / seconds / 1e6 << " M steps/s, checksum " << checksum << std::endl;
+    }
+}
+
+#endif
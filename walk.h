@@ -0,0 +1,229 @@
+#ifndef WALK_H
+#define WALK_H
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "distance.h"
+#include "hops.h"
+#include "kernel.h"
+#include "launch.h"
+#include "pyramid.h"
+
+/* smallest jump worth its trigonometry; closer walkers take lattice steps */
+const double MIN_JUMP = 4.0;
+
+/* distance kept between a jump's landing circle and the crystal */
+const double JUMP_MARGIN = 2.0;
+
+/* how a walker far from the crystal crosses empty space */
+enum class WalkMode {
+    STEP,   /* single lattice steps only */
+    JUMP,   /* walk-on-spheres jumps onto the largest empty circle */
+    HOP,    /* 2^k steps at once from precomputed displacement tables */
+    SQUARE  /* straight to the exit point of the largest empty square */
+};
+
+/* converts the --walk option to a WalkMode */
+inline WalkMode walkMode(const std::string& name) {
+    if (name == "jump") {
+        return WalkMode::JUMP;
+    }
+    if (name == "hop") {
+        return WalkMode::HOP;
+    }
+    if (name == "square") {
+        return WalkMode::SQUARE;
+    }
+    return WalkMode::STEP;
+}
+
+/**********************************************************************
+ * boxes around every cell whose contents a walk's course depended on
+ *
+ * note: a walk replayed from the same stream against a crystal that
+ * only gained cells outside the boxes takes exactly the same course.
+ * The current box grows over each covered square until it would span
+ * more than SPAN cells, then a new one starts, so a walk that wanders
+ * around the crystal is not summed up as one box over all of it.
+***********************************************************************/
+class Footprint {
+public:
+    static constexpr int SPAN = 64;
+
+    /* empties the footprint, keeping its storage */
+    void clear() {
+        boxes_.clear();
+    }
+
+    /* covers the square of max-norm radius reach around (x, y) */
+    void cover(const int x, const int y, const int reach) {
+        if (!boxes_.empty()) {
+            Box& box = boxes_.back();
+            const int lowX = std::min(box.lowX, x - reach);
+            const int highX = std::max(box.highX, x + reach);
+            const int lowY = std::min(box.lowY, y - reach);
+            const int highY = std::max(box.highY, y + reach);
+            if (highX - lowX < SPAN && highY - lowY < SPAN) {
+                box = {lowX, highX, lowY, highY};
+                return;
+            }
+        }
+        boxes_.push_back({x - reach, x + reach, y - reach, y + reach});
+    }
+
+    bool covers(const int x, const int y) const {
+        for (const Box& box : boxes_) {
+            if (x >= box.lowX && x <= box.highX && y >= box.lowY && y <= box.highY) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Box {
+        int lowX, highX, lowY, highY;
+    };
+
+    std::vector<Box> boxes_;
+};
+
+/**********************************************************************
+ * per-particle settings and acceleration structures for walkParticle
+ *
+ * note: radius is the crystal's max-norm radius when the particle was
+ * launched, and sharedRadius, if not nullptr, the radius other threads
+ * keep raising during the walk, which crossings re-read; pyramid,
+ * distance, hops, exits, kill and kernel (for the uniform 9-move walk)
+ * are nullptr when not in use. A walk with a
+ * footprint records what it read there and stops next to the crystal
+ * without placing the particle.
+***********************************************************************/
+struct WalkSettings {
+    int center;
+    int radius;
+    int* sharedRadius;
+    OccupancyPyramid* pyramid;
+    DistanceField* distance;
+    const DisplacementTables* hops;
+    const ExitTables* exits;
+    const KillCircle* kill;
+    WalkMode mode;
+    const MoveKernel* kernel;
+    Footprint* footprint;
+};
+
+/* radius bounding the crystal now, for sizing a crossing */
+inline int currentRadius(const WalkSettings& walk) {
+    return walk.sharedRadius == nullptr ? walk.radius : __atomic_load_n(walk.sharedRadius, __ATOMIC_RELAXED);
+}
+
+/* records a cell that just joined the crystal in the acceleration structures */
+inline void recordStick(const WalkSettings& walk, const int x, const int y) {
+    if (walk.pyramid != nullptr) {
+        walk.pyramid->mark(x, y);
+    }
+    if (walk.distance != nullptr) {
+        walk.distance->update(x, y);
+    }
+}
+
+/**********************************************************************
+ * covers the cells an empty radius r at (x, y) was read from
+ *
+ * note: it comes from a 3x3 group of pyramid blocks no wider than r
+ * each, and shrinks if any of them gains a cell
+***********************************************************************/
+inline void coverEmptyRadius(const WalkSettings& walk, const int x, const int y, const int empty) {
+    if (walk.footprint != nullptr) {
+        walk.footprint->cover(x, y, 3 * empty);
+    }
+}
+
+/* covers the cells whose sticking would lower a distance d at (x, y) */
+inline void coverDistance(const WalkSettings& walk, const int x, const int y, const int distance) {
+    if (walk.footprint != nullptr) {
+        walk.footprint->cover(x, y, distance);
+    }
+}
+
+/**********************************************************************
+ * radius of the largest circle around (x, y) that is known to hold no
+ * crystal, less JUMP_MARGIN, and that stays inside the lattice
+ *
+ * note: the crystal lies within Euclidean distance radius * sqrt(2) of
+ * the center; the pyramid and distance field, if present, add local
+ * bounds that also hold inside the crystal's bounding circle. A local
+ * bound that beats the radius bound is covered in walk.footprint.
+***********************************************************************/
+inline double jumpRadius(const WalkSettings& walk, const int gridSize, const int x, const int y) {
+    const double dx = x - walk.center;
+    const double dy = y - walk.center;
+    const double bound = std::sqrt(dx * dx + dy * dy) - currentRadius(walk) * std::sqrt(2.0);
+    double clearance = bound;
+    if (walk.pyramid != nullptr) {
+        const int empty = walk.pyramid->emptyRadius(x, y);
+        if (empty + 1.0 > bound) {
+            clearance = std::max(clearance, empty + 1.0);
+            coverEmptyRadius(walk, x, y, empty);
+        }
+    }
+    if (walk.distance != nullptr) {
+        const int distance = walk.distance->distance(x, y);
+        if (distance > bound) {
+            clearance = std::max(clearance, static_cast<double>(distance));
+            coverDistance(walk, x, y, distance);
+        }
+    }
+    const int edge = std::min(std::min(x, gridSize - 1 - x), std::min(y, gridSize - 1 - y));
+    return std::min(clearance - JUMP_MARGIN, static_cast<double>(edge));
+}
+
+/**********************************************************************
+ * largest r such that the square of max-norm radius r around (x, y) is
+ * known to hold no crystal and lies inside the lattice
+ *
+ * note: the crystal lies inside the square of max-norm radius radius
+ * around the center; the pyramid and distance field, if present, add
+ * local bounds, the latter converted from Euclidean distance. A local
+ * bound that beats the radius bound is covered in walk.footprint.
+***********************************************************************/
+inline int squareClearance(const WalkSettings& walk, const int gridSize, const int x, const int y) {
+    const int bound = std::max(std::abs(x - walk.center), std::abs(y - walk.center)) - currentRadius(walk) - 1;
+    int clearance = bound;
+    if (walk.pyramid != nullptr) {
+        const int empty = walk.pyramid->emptyRadius(x, y);
+        if (empty > bound) {
+            clearance = std::max(clearance, empty);
+            coverEmptyRadius(walk, x, y, empty);
+        }
+    }
+    if (walk.distance != nullptr) {
+        const int distance = walk.distance->distance(x, y);
+        const int converted = static_cast<int>(std::ceil(distance / std::sqrt(2.0))) - 1;
+        if (converted > bound) {
+            clearance = std::max(clearance, converted);
+            coverDistance(walk, x, y, distance);
+        }
+    }
+    const int edge = std::min(std::min(x, gridSize - 1 - x), std::min(y, gridSize - 1 - y));
+    return std::min(clearance, edge);
+}
+
+/**********************************************************************
+ * moves (x, y) to a uniformly random point on the circle of the given
+ * radius around it, rounded to the lattice (walk-on-spheres step)
+***********************************************************************/
+template <typename G>
+void jumpOnCircle(G& generator, const double radius, int& x, int& y) {
+    std::uniform_real_distribution<double> distribution(0.0, 2.0 * M_PI);
+    const double angle = distribution(generator);
+    x += static_cast<int>(std::lround(radius * std::cos(angle)));
+    y += static_cast<int>(std::lround(radius * std::sin(angle)));
+}
+
+#endif